@@ -0,0 +1,61 @@
+#include "access_trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Helper: little endian encoding keeps traces portable between hosts
+static void encodeInt(unsigned char *buf, unsigned int v) {
+    buf[0] = v & 0xFF;
+    buf[1] = (v >> 8) & 0xFF;
+    buf[2] = (v >> 16) & 0xFF;
+    buf[3] = (v >> 24) & 0xFF;
+}
+
+static unsigned int decodeInt(const unsigned char *buf) {
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((unsigned int)buf[3] << 24);
+}
+
+FILE *openAccessTraceWriter(const char *fileName) {
+    unsigned char version[4];
+    FILE *trace = fopen(fileName, "wb");
+    if (!trace) return NULL;
+
+    encodeInt(version, AT_VERSION);
+    if (fwrite(AT_MAGIC, 1, 4, trace) != 4 || fwrite(version, 1, 4, trace) != 4) {
+        fclose(trace);
+        return NULL;
+    }
+    return trace;
+}
+
+void writeAccessRecord(FILE *trace, AT_Op op, PageNumber pageNum) {
+    unsigned char rec[AT_RECORD_SIZE];
+    rec[0] = (unsigned char)op;
+    encodeInt(rec + 1, (unsigned int)pageNum);
+    fwrite(rec, 1, AT_RECORD_SIZE, trace);
+}
+
+RC closeAccessTraceWriter(FILE *trace) {
+    if (!trace) return RC_FILE_HANDLE_NOT_INIT;
+    return (fclose(trace) == 0) ? RC_OK : RC_WRITE_FAILED;
+}
+
+FILE *openAccessTraceReader(const char *fileName) {
+    unsigned char header[8];
+    FILE *trace = fopen(fileName, "rb");
+    if (!trace) return NULL;
+
+    if (fread(header, 1, 8, trace) != 8 || memcmp(header, AT_MAGIC, 4) != 0 ||
+        decodeInt(header + 4) != AT_VERSION) {
+        fclose(trace);
+        return NULL;
+    }
+    return trace;
+}
+
+bool readAccessRecord(FILE *trace, AT_Record *record) {
+    unsigned char rec[AT_RECORD_SIZE];
+    if (fread(rec, 1, AT_RECORD_SIZE, trace) != AT_RECORD_SIZE) return false;
+    record->op = (AT_Op)rec[0];
+    record->pageNum = (PageNumber)decodeInt(rec + 1);
+    return true;
+}
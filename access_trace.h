@@ -0,0 +1,34 @@
+#ifndef ACCESS_TRACE_H
+#define ACCESS_TRACE_H
+
+#include "buffer_mgr.h"
+#include <stdio.h>
+
+// Binary trace of buffer pool calls. A file starts with the 4-byte magic
+// "BMAT" and a 4-byte version, followed by 5-byte records: one op byte and
+// the page number as a little endian 32-bit integer.
+#define AT_MAGIC "BMAT"
+#define AT_VERSION 1
+#define AT_RECORD_SIZE 5
+
+typedef enum AT_Op {
+	AT_PIN = 1,
+	AT_UNPIN = 2,
+	AT_MARK_DIRTY = 3
+} AT_Op;
+
+typedef struct AT_Record {
+	AT_Op op;
+	PageNumber pageNum;
+} AT_Record;
+
+// recording
+FILE *openAccessTraceWriter (const char *fileName);
+void writeAccessRecord (FILE *trace, AT_Op op, PageNumber pageNum);
+RC closeAccessTraceWriter (FILE *trace);
+
+// replay: readAccessRecord returns false at end of trace
+FILE *openAccessTraceReader (const char *fileName);
+bool readAccessRecord (FILE *trace, AT_Record *record);
+
+#endif
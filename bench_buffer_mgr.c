@@ -0,0 +1,388 @@
+/************************************************************
+ * Buffer manager benchmark driver
+ *
+ * Runs standard workloads against every replacement strategy
+ * and a range of pool sizes, then reports throughput, hit
+ * ratio, I/O counts and pin latency percentiles as CSV or JSON.
+ *
+ * usage: bench_buffer_mgr [-f csv|json] [-o file] [-n ops]
+ *        [-p filePages] [-s size,size,...] [-z skew] [-w workload]
+ *        [-S seed] [-e evictionWindow] [-a 0|1]
+ ************************************************************/
+#define _POSIX_C_SOURCE 200809L
+
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCH_FILE "bench_pagefile.bin"
+#define MAX_POOL_SIZES 16
+
+typedef enum Workload {
+    WL_UNIFORM = 0,
+    WL_ZIPF,
+    WL_SCAN,
+    WL_LOOP,
+    WL_MIXED,
+    NUM_WORKLOADS
+} Workload;
+
+static const char *workloadNames[NUM_WORKLOADS] = {
+    "uniform", "zipf", "scan", "loop", "mixed"
+};
+
+typedef struct StrategyInfo {
+    ReplacementStrategy strategy;
+    const char *name;
+} StrategyInfo;
+
+static const StrategyInfo strategies[] = {
+    { RS_FIFO, "FIFO" },
+    { RS_LRU, "LRU" },
+    { RS_CLOCK, "CLOCK" },
+    { RS_LFU, "LFU" },
+    { RS_LRU_K, "LRU-K" },
+    { RS_ADAPTIVE, "ADAPTIVE" },
+    { RS_SAMPLED_LRU, "SAMPLED-LRU" },
+    { RS_SAMPLED_LFU, "SAMPLED-LFU" }
+};
+#define NUM_STRATEGIES ((int)(sizeof(strategies) / sizeof(strategies[0])))
+
+typedef struct BenchConfig {
+    int numOps;
+    int filePages;
+    int poolSizes[MAX_POOL_SIZES];
+    int numPoolSizes;
+    double skew;
+    int onlyWorkload;           // -1 runs all
+    unsigned long long seed;
+    int evictionWindow;         // setEvictionWindow, 0 = off
+    bool admission;             // setAdmissionFilter
+    bool json;
+    FILE *out;
+} BenchConfig;
+
+typedef struct BenchResult {
+    double seconds;
+    int readIO;
+    int writeIO;
+    int misses;
+    long long p50, p99, p999;
+} BenchResult;
+
+/************************************************************
+ * WORKLOAD GENERATION
+ ************************************************************/
+
+static unsigned long long rngState;
+
+/* xorshift64* generator, reproducible across runs */
+static unsigned long long nextRandom(void) {
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 2685821657736338717ULL;
+}
+
+static double nextUniform(void) {
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Zipfian generator (Gray et al.), item 0 is the most popular */
+typedef struct Zipf {
+    int n;
+    double theta, alpha, zetan, eta;
+} Zipf;
+
+static void initZipf(Zipf *z, int n, double theta) {
+    double zeta2 = 0;
+    z->n = n;
+    z->theta = theta;
+    z->zetan = 0;
+    for (int i = 1; i <= n; i++) z->zetan += 1.0 / pow(i, theta);
+    for (int i = 1; i <= 2; i++) zeta2 += 1.0 / pow(i, theta);
+    z->alpha = 1.0 / (1.0 - theta);
+    z->eta = (1 - pow(2.0 / n, 1 - theta)) / (1 - zeta2 / z->zetan);
+}
+
+static int nextZipf(Zipf *z) {
+    double u = nextUniform();
+    double uz = u * z->zetan;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + pow(0.5, z->theta)) return 1;
+    int v = (int)(z->n * pow(z->eta * u - z->eta + 1, z->alpha));
+    return (v >= z->n) ? z->n - 1 : v;
+}
+
+/* Fill pages/writes with the access sequence of a workload */
+static void generateWorkload(Workload wl, const BenchConfig *cfg, int poolSize,
+                             int *pages, bool *writes) {
+    Zipf zipf;
+    // scramble hot ranks over the file (stride is coprime with filePages)
+    int stride = (cfg->filePages % 7919) ? 7919 : 7907;
+    // the loop is just larger than the pool: the classic LRU worst case
+    int loopLen = poolSize + poolSize / 4 + 1;
+    if (loopLen > cfg->filePages) loopLen = cfg->filePages;
+
+    rngState = cfg->seed;
+    if (wl == WL_ZIPF || wl == WL_MIXED) initZipf(&zipf, cfg->filePages, cfg->skew);
+
+    for (int i = 0; i < cfg->numOps; i++) {
+        writes[i] = false;
+        switch (wl) {
+            case WL_UNIFORM: pages[i] = (int)(nextRandom() % cfg->filePages); break;
+            case WL_ZIPF: pages[i] = (int)(((long long)nextZipf(&zipf) * stride) % cfg->filePages); break;
+            case WL_SCAN: pages[i] = i % cfg->filePages; break;
+            case WL_LOOP: pages[i] = i % loopLen; break;
+            case WL_MIXED:
+                pages[i] = (int)(((long long)nextZipf(&zipf) * stride) % cfg->filePages);
+                writes[i] = (nextRandom() % 10) < 3;
+                break;
+            default: break;
+        }
+    }
+}
+
+/************************************************************
+ * MEASUREMENT
+ ************************************************************/
+
+static long long nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int compareLongLong(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static long long percentile(const long long *sorted, int n, double p) {
+    int idx = (int)(p * (n - 1) + 0.5);
+    return sorted[idx];
+}
+
+/* Run one access sequence against a fresh pool */
+static RC runWorkload(const BenchConfig *cfg, ReplacementStrategy strategy, int poolSize,
+                      const int *pages, const bool *writes, long long *latency,
+                      BenchResult *result) {
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    RC rc;
+
+    rc = initBufferPool(&bm, BENCH_FILE, poolSize, strategy, NULL);
+    if (rc != RC_OK) return rc;
+    setEvictionWindow(&bm, cfg->evictionWindow);
+    setAdmissionFilter(&bm, cfg->admission);
+
+    long long start = nowNs();
+    for (int i = 0; i < cfg->numOps; i++) {
+        long long t0 = nowNs();
+        rc = pinPage(&bm, &h, pages[i]);
+        latency[i] = nowNs() - t0;
+        if (rc != RC_OK) {
+            shutdownBufferPool(&bm);
+            return rc;
+        }
+        if (writes[i]) {
+            h.data[i % 64] = (char)i;
+            markDirty(&bm, &h);
+        }
+        unpinPage(&bm, &h);
+    }
+    result->seconds = (nowNs() - start) / 1e9;
+
+    BM_PoolStats stats;
+    getPoolStats(&bm, &stats);
+    result->readIO = (int)stats.readIO;
+    result->writeIO = (int)stats.writeIO;
+    result->misses = (int)stats.misses;
+
+    qsort(latency, cfg->numOps, sizeof(long long), compareLongLong);
+    result->p50 = percentile(latency, cfg->numOps, 0.50);
+    result->p99 = percentile(latency, cfg->numOps, 0.99);
+    result->p999 = percentile(latency, cfg->numOps, 0.999);
+
+    return shutdownBufferPool(&bm);
+}
+
+/************************************************************
+ * REPORTING
+ ************************************************************/
+
+static void printHeader(const BenchConfig *cfg) {
+    if (cfg->json)
+        fprintf(cfg->out, "[\n");
+    else
+        fprintf(cfg->out, "workload,strategy,pool_pages,ops,seconds,ops_per_sec,hit_ratio,"
+                "read_io,write_io,p50_ns,p99_ns,p999_ns\n");
+}
+
+static void printResult(const BenchConfig *cfg, const char *workload, const char *strategy,
+                        int poolSize, const BenchResult *r, bool first) {
+    double opsPerSec = r->seconds > 0 ? cfg->numOps / r->seconds : 0;
+    double hitRatio = 1.0 - (double)r->misses / cfg->numOps;
+
+    if (cfg->json)
+        fprintf(cfg->out, "%s  {\"workload\": \"%s\", \"strategy\": \"%s\", \"pool_pages\": %d, "
+                "\"ops\": %d, \"seconds\": %.6f, \"ops_per_sec\": %.0f, \"hit_ratio\": %.4f, "
+                "\"read_io\": %d, \"write_io\": %d, \"p50_ns\": %lld, \"p99_ns\": %lld, "
+                "\"p999_ns\": %lld}",
+                first ? "" : ",\n", workload, strategy, poolSize, cfg->numOps, r->seconds,
+                opsPerSec, hitRatio, r->readIO, r->writeIO, r->p50, r->p99, r->p999);
+    else
+        fprintf(cfg->out, "%s,%s,%d,%d,%.6f,%.0f,%.4f,%d,%d,%lld,%lld,%lld\n",
+                workload, strategy, poolSize, cfg->numOps, r->seconds, opsPerSec, hitRatio,
+                r->readIO, r->writeIO, r->p50, r->p99, r->p999);
+}
+
+static void printFooter(const BenchConfig *cfg) {
+    if (cfg->json) fprintf(cfg->out, "\n]\n");
+}
+
+/************************************************************
+ * DRIVER
+ ************************************************************/
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-f csv|json] [-o file] [-n ops] [-p filePages] "
+            "[-s size,size,...] [-z skew] [-w workload] [-S seed] [-e evictionWindow] "
+            "[-a 0|1]\n", prog);
+    exit(2);
+}
+
+static void parseArgs(int argc, char **argv, BenchConfig *cfg) {
+    cfg->numOps = 20000;
+    cfg->filePages = 1000;
+    cfg->numPoolSizes = 4;
+    cfg->poolSizes[0] = 10;
+    cfg->poolSizes[1] = 50;
+    cfg->poolSizes[2] = 100;
+    cfg->poolSizes[3] = 250;
+    cfg->skew = 0.99;
+    cfg->onlyWorkload = -1;
+    cfg->seed = 0x9E3779B97F4A7C15ULL;
+    cfg->evictionWindow = 0;
+    cfg->admission = false;
+    cfg->json = false;
+    cfg->out = stdout;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        const char *opt = argv[i], *val = argv[++i];
+        if (strcmp(opt, "-f") == 0) {
+            if (strcmp(val, "json") == 0) cfg->json = true;
+            else if (strcmp(val, "csv") != 0) usage(argv[0]);
+        } else if (strcmp(opt, "-o") == 0) {
+            cfg->out = fopen(val, "w");
+            if (!cfg->out) { perror(val); exit(1); }
+        } else if (strcmp(opt, "-n") == 0) {
+            cfg->numOps = atoi(val);
+        } else if (strcmp(opt, "-p") == 0) {
+            cfg->filePages = atoi(val);
+        } else if (strcmp(opt, "-s") == 0) {
+            char *copy = strdup(val), *tok;
+            cfg->numPoolSizes = 0;
+            for (tok = strtok(copy, ","); tok && cfg->numPoolSizes < MAX_POOL_SIZES; tok = strtok(NULL, ","))
+                cfg->poolSizes[cfg->numPoolSizes++] = atoi(tok);
+            free(copy);
+        } else if (strcmp(opt, "-z") == 0) {
+            cfg->skew = atof(val);
+        } else if (strcmp(opt, "-w") == 0) {
+            cfg->onlyWorkload = -1;
+            for (int w = 0; w < NUM_WORKLOADS; w++)
+                if (strcmp(val, workloadNames[w]) == 0) cfg->onlyWorkload = w;
+            if (cfg->onlyWorkload < 0) usage(argv[0]);
+        } else if (strcmp(opt, "-S") == 0) {
+            cfg->seed = strtoull(val, NULL, 0);
+        } else if (strcmp(opt, "-e") == 0) {
+            cfg->evictionWindow = atoi(val);
+        } else if (strcmp(opt, "-a") == 0) {
+            cfg->admission = atoi(val) != 0;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (cfg->numOps <= 0 || cfg->filePages <= 1 || cfg->numPoolSizes == 0) usage(argv[0]);
+    if (cfg->skew <= 0 || cfg->skew == 1.0) {
+        fprintf(stderr, "skew must be positive and different from 1\n");
+        exit(2);
+    }
+}
+
+#define FILL_RUN_PAGES 64
+
+/* Create the benchmark page file with filePages pages of real content:
+   pages only grown by ensureCapacity are holes the storage manager serves
+   from its zero map, so misses would never reach the disk */
+static RC createBenchFile(int filePages) {
+    SM_FileHandle fh;
+    RC rc = createPageFile(BENCH_FILE);
+    if (rc != RC_OK) return rc;
+    rc = openPageFile(BENCH_FILE, &fh);
+    if (rc != RC_OK) return rc;
+    rc = ensureCapacity(filePages, &fh);
+
+    char *run = (char *)malloc((size_t)FILL_RUN_PAGES * PAGE_SIZE);
+    if (!run && rc == RC_OK) rc = RC_WRITE_FAILED;
+    for (int p = 0; rc == RC_OK && p < filePages; p += FILL_RUN_PAGES) {
+        int count = (filePages - p < FILL_RUN_PAGES) ? filePages - p : FILL_RUN_PAGES;
+        for (int i = 0; i < count; i++) {
+            char *page = run + (size_t)i * PAGE_SIZE;
+            memset(page, 'a' + (p + i) % 26, PAGE_SIZE);
+            sprintf(page, "Page-%d", p + i);
+        }
+        rc = writeBlocks(p, count, &fh, run);
+    }
+    free(run);
+    closePageFile(&fh);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    BenchConfig cfg;
+    BenchResult result;
+    bool first = true;
+
+    parseArgs(argc, argv, &cfg);
+    initStorageManager();
+    CHECK(createBenchFile(cfg.filePages));
+
+    int *pages = (int *)malloc(sizeof(int) * cfg.numOps);
+    bool *writes = (bool *)malloc(sizeof(bool) * cfg.numOps);
+    long long *latency = (long long *)malloc(sizeof(long long) * cfg.numOps);
+    if (!pages || !writes || !latency) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printHeader(&cfg);
+    for (int w = 0; w < NUM_WORKLOADS; w++) {
+        if (cfg.onlyWorkload >= 0 && w != cfg.onlyWorkload) continue;
+        for (int p = 0; p < cfg.numPoolSizes; p++) {
+            generateWorkload((Workload)w, &cfg, cfg.poolSizes[p], pages, writes);
+            for (int s = 0; s < NUM_STRATEGIES; s++) {
+                CHECK(runWorkload(&cfg, strategies[s].strategy, cfg.poolSizes[p],
+                                  pages, writes, latency, &result));
+                printResult(&cfg, workloadNames[w], strategies[s].name, cfg.poolSizes[p],
+                            &result, first);
+                first = false;
+            }
+        }
+    }
+    printFooter(&cfg);
+
+    if (cfg.out != stdout) fclose(cfg.out);
+    free(pages);
+    free(writes);
+    free(latency);
+    CHECK(destroyPageFile(BENCH_FILE));
+    return 0;
+}
@@ -1,10 +1,21 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 #include "dberror.h"
+#include "victim_cache.h"
+#include "l2_cache.h"
+#include "freq_sketch.h"
+#include "miss_ratio.h"
+#include "access_trace.h"
+#include "event_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
 
 // Internal data structures
 typedef struct Frame {
@@ -12,35 +23,224 @@ typedef struct Frame {
     char *data;
     bool dirty;
     int fixCount;
+    bool ringFrame;     // loaded through an access strategy ring
     int lastAccessTime;
     int loadTime;
     int accessCount;
     int *accessHistory;
     int historySize;
+    long long dirtySeq;     // when the page first became dirty
+    int dirtyPrev;          // dirty list links, -1 at the ends
+    int dirtyNext;
+    int partition;          // owning partition, -1 while empty
+    BM_PinPriority priority;    // highest pin priority since the page was loaded
+    bool sticky;            // exempt from eviction (setPageResidency)
 } Frame;
 
+typedef struct EvictCandidate {
+    long long rank;
+    int frame;
+} EvictCandidate;
+
+// Sampled strategies: each miss ranks sampleSize random frames and merges
+// them into a pool of the best candidates seen so far, which carries over to
+// the next miss; the victim is the best entry that still holds its page
+#define BM_DEFAULT_SAMPLE_SIZE 5
+#define BM_SAMPLE_POOL 16
+#define BM_SAMPLE_ROUNDS 4      // sample rounds before falling back to a scan
+
+typedef struct SampleEntry {
+    long long rank;
+    int frame;
+    PageNumber pageNum;         // the entry is stale once the frame moves on
+} SampleEntry;
+
+// Adaptive mode: every candidate strategy runs on a shadow cache fed with
+// a hash sample of the pinned page numbers and sized to the same fraction of
+// the pool; the live strategy follows the shadow with the most hits. Shadows
+// are scanned linearly, so their size is capped and larger pools sample
+// fewer pages instead, keeping the work per pin constant.
+#define ADAPT_MAX_SHADOW 64     // shadow entries before sampling sparser
+#define ADAPT_MAX_SAMPLE 65536  // 1 in 2^16 pages: all the hash bits used
+#define ADAPT_EPOCH 512         // sampled pins between decisions
+#define ADAPT_HYSTERESIS 0.02   // hit-ratio lead needed to switch
+
+typedef struct ShadowCache {
+    Frame *entries;
+    int capacity;
+    int used;
+    int hand;
+    int time;
+    int hits;                   // in the current epoch
+} ShadowCache;
+
+typedef struct AdaptState {
+    ShadowCache shadows[RS_ADAPTIVE];   // indexed by strategy
+    unsigned int sampleMask;
+    int sampled;                        // sampled pins in the current epoch
+} AdaptState;
+
+// Admission filter: misses the sketch rejects are served from this many
+// frames kept after the pool's own, reused round robin
+#define BM_TRANSIENT_FRAMES 4
+
+// pages reserved by pinNewPage reach the file when first flushed, which
+// grows it by whole extents of this many pages
+#define NEW_PAGE_EXTENT 16
+
+typedef struct BM_Partition {
+    bool used;
+    char name[BM_PARTITION_NAME_LEN];
+    int minFrames;
+    int maxFrames;
+    int frames;                 // frames currently charged to it
+    BM_PartitionStats stats;
+} BM_Partition;
+
+// A thread waiting in pinPage for a frame; lives on the waiter's stack
+typedef struct BM_Waiter {
+    pthread_cond_t wake;
+    struct BM_Waiter *next;
+} BM_Waiter;
+
 typedef struct BM_MgmtData {
     Frame *frames;
     int numFrames;
+    // page number -> frame: chained hash with one link per frame
+    int *pageBuckets;
+    int *pageChain;
+    unsigned int bucketMask;
+    int numEmpty;
+    int emptyHint;              // every frame below it holds a page
+    int pageSize;               // of the page file, and of every frame
     SM_FileHandle *fileHandle;
-    int numReadIO;
-    int numWriteIO;
+    BM_PoolStats stats;         // updated under the pool lock in concurrent mode
     int clockHand;
     int timeCounter;
+    ReplacementStrategy liveStrategy;   // ranks victims; differs from bm->strategy when adaptive
+    AdaptState *adapt;                  // NULL unless RS_ADAPTIVE
+    VC_Cache *victimCache;
+    L2_Cache *l2Cache;          // file-backed tier for clean evicted pages
+    FS_Sketch *admission;       // TinyLFU frequency sketch, NULL when off
+    int transientHand;
+    MR_Tracker *missRatio;      // SHARDS reuse-distance sampling, NULL when off
+    bool warmRestart;           // save the resident page list at shutdown
+    FILE *accessTrace;          // pin/unpin/markDirty recording, NULL when off
+    // dirty frames, oldest first-dirty time at the head
+    int dirtyHead;
+    int dirtyTail;
+    int numDirty;
+    long long dirtyCounter;
+    PageNumber nextNewPage;     // next page number pinNewPage hands out
+    // clean-preferring eviction: the victim is the best clean frame among
+    // the evictionWindow best-ranked candidates (0 = plain strategy order)
+    int evictionWindow;
+    EvictCandidate *candidates;
+    int sampleSize;
+    unsigned int sampleSeed;
+    SampleEntry samplePool[BM_SAMPLE_POOL];
+    int samplePoolCount;
+    // frame quotas; partition 0 is the default one, and pins are charged to
+    // pinPartition. victimPartition restricts victim scans (-1 = any frame).
+    BM_Partition partitions[BM_MAX_PARTITIONS];
+    int numPartitions;
+    int pinPartition;
+    int victimPartition;
+    // priority of the pin in progress, and frames above or below normal
+    BM_PinPriority pinPriority;
+    int numPriorityFrames;
+    int numSticky;
+    int stickyLimit;            // frames that may be sticky at once
+    // incremental checkpoint: flush pages dirtied up to the horizon,
+    // at most pagesPerSecond of them (0 = no cap)
+    bool checkpointActive;
+    bool checkpointPaused;
+    long long checkpointHorizon;
+    int pagesPerSecond;
+    double checkpointTokens;
+    long long checkpointRefillNs;
+    // concurrent mode: the pin, unpin, dirty and flush calls hold poolLock.
+    // Misses that find every frame pinned queue in FIFO order for up to
+    // pinWaitMs (0 = fail at once, < 0 = no limit); unpins wake the head.
+    bool concurrent;
+    pthread_mutex_t poolLock;
+    int pinWaitMs;
+    BM_Waiter *waitHead;
+    BM_Waiter *waitTail;
+    bool noVictim;              // the last claimFrame found every frame pinned
+    bool pinRetry;              // the pin in progress is a waiter's retry
 } BM_MgmtData;
 
+// Helper: take the pool lock in concurrent mode
+static void lockPool(BM_MgmtData *mgmtData) {
+    if (mgmtData->concurrent) pthread_mutex_lock(&mgmtData->poolLock);
+}
+
+static void unlockPool(BM_MgmtData *mgmtData) {
+    if (mgmtData->concurrent) pthread_mutex_unlock(&mgmtData->poolLock);
+}
+
+// Helper: monotonic clock in nanoseconds
+static long long nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Helper: log2 histogram bucket of a latency
+static int latencyBucket(long long ns) {
+    if (ns < 2) return 0;
+    int bucket = 63 - __builtin_clzll((unsigned long long)ns);
+    return (bucket < BM_LATENCY_BUCKETS) ? bucket : BM_LATENCY_BUCKETS - 1;
+}
+
+// Helper: hash bucket of a page number
+static int *pageBucket(BM_MgmtData *mgmtData, PageNumber pageNum) {
+    return &mgmtData->pageBuckets[((unsigned)pageNum * 2654435761u) & mgmtData->bucketMask];
+}
+
+// Helper: find the lowest empty frame
+static int findEmptyFrame(BM_MgmtData *mgmtData) {
+    if (mgmtData->numEmpty == 0) return -1;
+    for (int i = mgmtData->emptyHint; i < mgmtData->numFrames; i++)
+        if (mgmtData->frames[i].pageNum == NO_PAGE) {
+            mgmtData->emptyHint = i;
+            return i;
+        }
+    return -1;
+}
+
 // Helper: find frame with page
 static int findFrame(BM_MgmtData *mgmtData, PageNumber pageNum) {
-    for (int i = 0; i < mgmtData->numFrames; i++)
+    if (pageNum == NO_PAGE) return findEmptyFrame(mgmtData);
+    for (int i = *pageBucket(mgmtData, pageNum); i >= 0; i = mgmtData->pageChain[i])
         if (mgmtData->frames[i].pageNum == pageNum) return i;
     return -1;
 }
 
-// Helper: find empty frame
-static int findEmptyFrame(BM_MgmtData *mgmtData) {
-    for (int i = 0; i < mgmtData->numFrames; i++)
-        if (mgmtData->frames[i].pageNum == NO_PAGE) return i;
-    return -1;
+// Helper: change the page a frame holds (NO_PAGE empties it), keeping the
+// page index and the empty frame count in step
+static void setFramePage(BM_MgmtData *mgmtData, int frameIndex, PageNumber pageNum) {
+    Frame *frame = &mgmtData->frames[frameIndex];
+    if (frame->pageNum == pageNum) return;
+    
+    if (frame->pageNum != NO_PAGE) {
+        int *link = pageBucket(mgmtData, frame->pageNum);
+        while (*link != frameIndex) link = &mgmtData->pageChain[*link];
+        *link = mgmtData->pageChain[frameIndex];
+    } else if (frameIndex < mgmtData->numFrames) {
+        mgmtData->numEmpty--;
+    }
+    
+    frame->pageNum = pageNum;
+    if (pageNum != NO_PAGE) {
+        int *bucket = pageBucket(mgmtData, pageNum);
+        mgmtData->pageChain[frameIndex] = *bucket;
+        *bucket = frameIndex;
+    } else if (frameIndex < mgmtData->numFrames) {
+        mgmtData->numEmpty++;
+        if (frameIndex < mgmtData->emptyHint) mgmtData->emptyHint = frameIndex;
+    }
 }
 
 // Helper: update LRU-K history
@@ -58,224 +258,1384 @@ static void updateLRUKHistory(Frame *frame, int time, int k) {
     }
 }
 
+// Helper: whether frames keep the metadata strategy s ranks by; adaptive
+// pools keep all of it so the live strategy can change at any time
+static bool tracksStrategy(BM_BufferPool *const bm, ReplacementStrategy s) {
+    if (bm->strategy == RS_SAMPLED_LRU) return s == RS_LRU;
+    if (bm->strategy == RS_SAMPLED_LFU) return s == RS_LFU;
+    return bm->strategy == s || bm->strategy == RS_ADAPTIVE;
+}
+
+// Helper: replacement rank of a frame, the lowest rank is evicted first
+static int frameRank(ReplacementStrategy strategy, Frame *frame) {
+    switch (strategy) {
+        case RS_FIFO: return frame->loadTime;
+        case RS_LRU: case RS_SAMPLED_LRU: return frame->lastAccessTime;
+        case RS_LFU: case RS_SAMPLED_LFU: return frame->accessCount;
+        case RS_LRU_K: return (frame->historySize >= 2) ? frame->accessHistory[0] : 0;
+        default: return INT_MAX;
+    }
+}
+
+// Helper: whether a frame may be chosen as the victim of the current scan
+static bool evictable(BM_MgmtData *mgmtData, Frame *frame) {
+    if (frame->fixCount > 0 || frame->sticky) return false;
+    return mgmtData->victimPartition < 0 || frame->partition == mgmtData->victimPartition;
+}
+
+// Helper: victim order of a frame: pin priority first, then strategy rank
+static long long victimKey(BM_MgmtData *mgmtData, Frame *frame) {
+    return ((long long)frame->priority << 32) + frameRank(mgmtData->liveStrategy, frame);
+}
+
+// Helper: lowest priority among the frames the scan may take
+static BM_PinPriority lowestPriority(BM_MgmtData *mgmtData) {
+    BM_PinPriority lowest = BM_PRIORITY_HIGH;
+    if (mgmtData->numPriorityFrames == 0) return BM_PRIORITY_NORMAL;
+    for (int i = 0; i < mgmtData->numFrames; i++) {
+        Frame *frame = &mgmtData->frames[i];
+        if (evictable(mgmtData, frame) && frame->priority < lowest) lowest = frame->priority;
+    }
+    return lowest;
+}
+
+// Helper: pick a victim among the evictionWindow best candidates, preferring
+// a clean frame so the pin does not wait on a write. CLOCK candidates are
+// the next unpinned frames from the hand, the others are ranked.
+static int scanCleanVictim(BM_BufferPool *const bm) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    EvictCandidate *cand = mgmtData->candidates;
+    int window = mgmtData->evictionWindow, count = 0;
+    BM_PinPriority lowest = (mgmtData->liveStrategy == RS_CLOCK) ? lowestPriority(mgmtData) : BM_PRIORITY_LOW;
+    
+    for (int n = 0; n < mgmtData->numFrames; n++) {
+        int i = (mgmtData->liveStrategy == RS_CLOCK) ? (mgmtData->clockHand + n) % mgmtData->numFrames : n;
+        Frame *frame = &mgmtData->frames[i];
+        if (!evictable(mgmtData, frame)) continue;
+        if (frame->pageNum == NO_PAGE) return i;
+        
+        if (mgmtData->liveStrategy == RS_CLOCK) {
+            if (frame->priority > lowest) continue;
+            cand[count].frame = i;
+            if (++count == window) break;
+            continue;
+        }
+        
+        // insertion into the sorted window; equal ranks keep frame order
+        long long rank = victimKey(mgmtData, frame);
+        if (count == window && rank >= cand[count - 1].rank) continue;
+        int pos = (count < window) ? count++ : count - 1;
+        while (pos > 0 && cand[pos - 1].rank > rank) {
+            cand[pos] = cand[pos - 1];
+            pos--;
+        }
+        cand[pos].rank = rank;
+        cand[pos].frame = i;
+    }
+    if (count == 0) return -1;
+    
+    int victim = cand[0].frame;
+    for (int c = 0; c < count; c++)
+        if (!mgmtData->frames[cand[c].frame].dirty) {
+            victim = cand[c].frame;
+            break;
+        }
+    return victim;
+}
+
+// Helper: merge a sampled frame into the candidate pool, which is sorted by
+// rank and drops its worst entry when full
+static void poolCandidate(BM_MgmtData *mgmtData, int frameIndex, long long rank) {
+    SampleEntry *pool = mgmtData->samplePool;
+    int count = mgmtData->samplePoolCount;
+    
+    for (int c = 0; c < count; c++)
+        if (pool[c].frame == frameIndex) {
+            memmove(&pool[c], &pool[c + 1], sizeof(SampleEntry) * (count - c - 1));
+            count--;
+            break;
+        }
+    if (count == BM_SAMPLE_POOL && rank >= pool[count - 1].rank) {
+        mgmtData->samplePoolCount = count;
+        return;
+    }
+    int pos = (count < BM_SAMPLE_POOL) ? count++ : count - 1;
+    while (pos > 0 && pool[pos - 1].rank > rank) {
+        pool[pos] = pool[pos - 1];
+        pos--;
+    }
+    pool[pos].rank = rank;
+    pool[pos].frame = frameIndex;
+    pool[pos].pageNum = mgmtData->frames[frameIndex].pageNum;
+    mgmtData->samplePoolCount = count;
+}
+
+// Helper: pick the victim from the candidate pool: entries whose page left
+// are dropped, the others re-ranked, and the best evictable one wins (the
+// first clean one among the best evictionWindow, if set). -1 if none. The
+// victim stays in the pool until commitVictim.
+static int takePoolVictim(BM_MgmtData *mgmtData) {
+    SampleEntry *pool = mgmtData->samplePool;
+    int count = 0;
+    
+    for (int c = 0; c < mgmtData->samplePoolCount; c++) {
+        Frame *frame = &mgmtData->frames[pool[c].frame];
+        if (frame->pageNum == NO_PAGE || frame->pageNum != pool[c].pageNum) continue;
+        SampleEntry entry = pool[c];
+        entry.rank = victimKey(mgmtData, frame);
+        int pos = count++;
+        while (pos > 0 && pool[pos - 1].rank > entry.rank) {
+            pool[pos] = pool[pos - 1];
+            pos--;
+        }
+        pool[pos] = entry;
+    }
+    mgmtData->samplePoolCount = count;
+    
+    int window = (mgmtData->evictionWindow > 1) ? mgmtData->evictionWindow : 1;
+    int best = -1, seen = 0;
+    for (int c = 0; c < count && seen < window; c++) {
+        if (!evictable(mgmtData, &mgmtData->frames[pool[c].frame])) continue;
+        if (best < 0) best = c;
+        seen++;
+        if (window > 1 && !mgmtData->frames[pool[c].frame].dirty) {
+            best = c;
+            break;
+        }
+    }
+    return (best < 0) ? -1 : pool[best].frame;
+}
+
+// Helper: sampled victim selection; only falls back to ranking every frame
+// when several rounds of samples found nothing to evict
+static int sampleVictimFrame(BM_MgmtData *mgmtData) {
+    for (int round = 0; round < BM_SAMPLE_ROUNDS; round++) {
+        for (int n = 0; n < mgmtData->sampleSize; n++) {
+            // xorshift32
+            unsigned int x = mgmtData->sampleSeed;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            mgmtData->sampleSeed = x;
+            
+            int i = (int)(x % (unsigned)mgmtData->numFrames);
+            Frame *frame = &mgmtData->frames[i];
+            if (!evictable(mgmtData, frame)) continue;
+            if (frame->pageNum == NO_PAGE) return i;
+            poolCandidate(mgmtData, i, victimKey(mgmtData, frame));
+        }
+        int victim = takePoolVictim(mgmtData);
+        if (victim >= 0) return victim;
+    }
+    
+    int victim = -1;
+    long long minVal = LLONG_MAX;
+    for (int i = 0; i < mgmtData->numFrames; i++) {
+        Frame *frame = &mgmtData->frames[i];
+        if (!evictable(mgmtData, frame)) continue;
+        if (frame->pageNum == NO_PAGE) return i;
+        long long val = victimKey(mgmtData, frame);
+        if (val < minVal) { minVal = val; victim = i; }
+    }
+    return victim;
+}
+
 // Helper: select victim frame
-static int selectVictimFrame(BM_BufferPool *const bm) {
+static int scanVictimFrame(BM_BufferPool *const bm) {
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
-    int victim = -1, minVal = INT_MAX, emptyFrame = -1;
+    int victim = -1, emptyFrame = -1;
+    long long minVal = LLONG_MAX;
+    
+    if (mgmtData->liveStrategy == RS_SAMPLED_LRU || mgmtData->liveStrategy == RS_SAMPLED_LFU)
+        return sampleVictimFrame(mgmtData);
+    if (mgmtData->evictionWindow > 1) return scanCleanVictim(bm);
+    
+    // within a partition, or past sticky and prioritized frames, the hand
+    // moves on to the next frame of the lowest priority it may take
+    if (mgmtData->liveStrategy == RS_CLOCK &&
+        (mgmtData->victimPartition >= 0 || mgmtData->numPriorityFrames > 0 || mgmtData->numSticky > 0)) {
+        BM_PinPriority lowest = lowestPriority(mgmtData);
+        for (int n = 0; n < mgmtData->numFrames; n++) {
+            int i = (mgmtData->clockHand + n) % mgmtData->numFrames;
+            Frame *frame = &mgmtData->frames[i];
+            if (!evictable(mgmtData, frame) || frame->priority > lowest) continue;
+            return i;
+        }
+        return -1;
+    }
     
     for (int i = 0; i < mgmtData->numFrames; i++) {
-        if (mgmtData->frames[i].fixCount > 0) continue;
+        if (!evictable(mgmtData, &mgmtData->frames[i])) continue;
         if (mgmtData->frames[i].pageNum == NO_PAGE) {
             emptyFrame = i;
             break;
         }
         
-        int val = INT_MAX;
-        switch (bm->strategy) {
-            case RS_FIFO: val = mgmtData->frames[i].loadTime; break;
-            case RS_LRU: val = mgmtData->frames[i].lastAccessTime; break;
-            case RS_LFU: val = mgmtData->frames[i].accessCount; break;
-            case RS_LRU_K:
-                val = (mgmtData->frames[i].historySize >= 2) ? 
-                      mgmtData->frames[i].accessHistory[0] : 0;
-                break;
-            case RS_CLOCK:
-                if (mgmtData->clockHand == i) {
-                    victim = i;
-                    mgmtData->clockHand = (mgmtData->clockHand + 1) % mgmtData->numFrames;
-                    return victim;
-                }
-                continue;
+        if (mgmtData->liveStrategy == RS_CLOCK) {
+            if (mgmtData->clockHand == i) return i;
+            continue;
         }
+        long long val = victimKey(mgmtData, &mgmtData->frames[i]);
         if (val < minVal) { minVal = val; victim = i; }
     }
     return (emptyFrame >= 0) ? emptyFrame : victim;
 }
 
-// Helper: write frame to disk
-static RC writeFrameToDisk(BM_BufferPool *const bm, int frameIndex) {
-    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+// Helper: select victim frame, traced. Selection leaves the pool as it was;
+// commitVictim applies its bookkeeping once the frame is really evicted.
+static int selectVictimFrame(BM_BufferPool *const bm) {
+    ET_BEGIN(start);
+    int victim = scanVictimFrame(bm);
+    ET_END(ET_SELECT_VICTIM, NO_PAGE, victim, start);
+    return victim;
+}
+
+// Helper: the victim's page is about to go: count a dirty pick within the
+// eviction window, move the CLOCK hand past it and drop its sample entry
+static void commitVictim(BM_MgmtData *mgmtData, int frameIndex) {
     Frame *frame = &mgmtData->frames[frameIndex];
+    if (frame->pageNum == NO_PAGE) return;
     
-    if (frame->dirty && frame->pageNum != NO_PAGE) {
-        RC rc = writeBlock(frame->pageNum, mgmtData->fileHandle, frame->data);
-        if (rc != RC_OK) return rc;
-        frame->dirty = false;
-        mgmtData->numWriteIO++;
-    }
-    return RC_OK;
+    if (mgmtData->evictionWindow > 1 && frame->dirty) mgmtData->stats.dirtyFallbacks++;
+    if (mgmtData->liveStrategy == RS_CLOCK) mgmtData->clockHand = (frameIndex + 1) % mgmtData->numFrames;
+    SampleEntry *pool = mgmtData->samplePool;
+    for (int c = 0; c < mgmtData->samplePoolCount; c++)
+        if (pool[c].frame == frameIndex) {
+            memmove(&pool[c], &pool[c + 1], sizeof(SampleEntry) * (mgmtData->samplePoolCount - c - 1));
+            mgmtData->samplePoolCount--;
+            break;
+        }
 }
 
-// Helper: cleanup frames
-static void cleanupFrames(BM_MgmtData *mgmtData, int numFrames) {
-    for (int i = 0; i < numFrames; i++) {
-        free(mgmtData->frames[i].data);
-        free(mgmtData->frames[i].accessHistory);
+// Helper: mark a frame dirty, appending it to the dirty list the first time
+static void setFrameDirty(BM_MgmtData *mgmtData, int frameIndex) {
+    Frame *frame = &mgmtData->frames[frameIndex];
+    if (frame->dirty) return;
+    frame->dirty = true;
+    frame->dirtySeq = ++mgmtData->dirtyCounter;
+    frame->dirtyPrev = mgmtData->dirtyTail;
+    frame->dirtyNext = -1;
+    if (mgmtData->dirtyTail >= 0) mgmtData->frames[mgmtData->dirtyTail].dirtyNext = frameIndex;
+    else mgmtData->dirtyHead = frameIndex;
+    mgmtData->dirtyTail = frameIndex;
+    mgmtData->numDirty++;
+}
+
+// Helper: mark a frame clean and unlink it from the dirty list
+static void clearFrameDirty(BM_MgmtData *mgmtData, int frameIndex) {
+    Frame *frame = &mgmtData->frames[frameIndex];
+    if (!frame->dirty) return;
+    frame->dirty = false;
+    if (frame->dirtyPrev >= 0) mgmtData->frames[frame->dirtyPrev].dirtyNext = frame->dirtyNext;
+    else mgmtData->dirtyHead = frame->dirtyNext;
+    if (frame->dirtyNext >= 0) mgmtData->frames[frame->dirtyNext].dirtyPrev = frame->dirtyPrev;
+    else mgmtData->dirtyTail = frame->dirtyPrev;
+    frame->dirtyPrev = frame->dirtyNext = -1;
+    mgmtData->numDirty--;
+}
+
+// Helper: run one pin through a shadow cache. Shadows mirror the pool's own
+// hit and load bookkeeping so each one behaves like the strategy it models.
+static void shadowAccess(ShadowCache *sc, ReplacementStrategy strategy, PageNumber pageNum) {
+    sc->time++;
+    for (int i = 0; i < sc->used; i++) {
+        Frame *e = &sc->entries[i];
+        if (e->pageNum != pageNum) continue;
+        sc->hits++;
+        e->lastAccessTime = sc->time;
+        e->accessCount++;
+        updateLRUKHistory(e, sc->time, 2);
+        return;
+    }
+    
+    int slot = 0;
+    if (sc->used < sc->capacity) {
+        slot = sc->used++;
+    } else if (strategy == RS_CLOCK) {
+        slot = sc->hand;
+        sc->hand = (sc->hand + 1) % sc->capacity;
+    } else {
+        for (int i = 1; i < sc->used; i++)
+            if (frameRank(strategy, &sc->entries[i]) < frameRank(strategy, &sc->entries[slot]))
+                slot = i;
     }
+    Frame *e = &sc->entries[slot];
+    e->pageNum = pageNum;
+    e->loadTime = sc->time;
+    e->lastAccessTime = sc->time;
+    e->accessCount = 1;
+    e->historySize = 0;
+    updateLRUKHistory(e, sc->time, 2);
 }
 
-// Initialize buffer pool
-RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
-                  const int numPages, ReplacementStrategy strategy, void *stratData) {
-    if (!bm || !pageFileName) return RC_FILE_NOT_FOUND;
+// Helper: feed a pin to the shadows and, once per epoch, switch the live
+// strategy to the best shadow if it leads by more than the hysteresis margin
+static void adaptObserve(BM_BufferPool *const bm, PageNumber pageNum) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    AdaptState *adapt = mgmtData->adapt;
     
-    BM_MgmtData *mgmtData = (BM_MgmtData *)malloc(sizeof(BM_MgmtData));
-    if (!mgmtData) return RC_WRITE_FAILED;
+    if ((((unsigned int)pageNum * 2654435761u) >> 16) & adapt->sampleMask) return;
+    for (int c = 0; c < RS_ADAPTIVE; c++)
+        shadowAccess(&adapt->shadows[c], (ReplacementStrategy)c, pageNum);
+    if (++adapt->sampled < ADAPT_EPOCH) return;
     
-    bm->pageFile = (char *)pageFileName;
-    bm->numPages = numPages;
-    bm->strategy = strategy;
-    bm->mgmtData = mgmtData;
+    int live = mgmtData->liveStrategy, best = live;
+    for (int c = 0; c < RS_ADAPTIVE; c++)
+        if (adapt->shadows[c].hits > adapt->shadows[best].hits) best = c;
+    if (best != live &&
+        adapt->shadows[best].hits - adapt->shadows[live].hits > ADAPT_HYSTERESIS * adapt->sampled) {
+        mgmtData->liveStrategy = (ReplacementStrategy)best;
+        mgmtData->stats.strategySwitches++;
+    }
+    for (int c = 0; c < RS_ADAPTIVE; c++) adapt->shadows[c].hits = 0;
+    adapt->sampled = 0;
+}
+
+// Helper: set up the shadow caches of an adaptive pool
+static AdaptState *createAdaptState(int numFrames) {
+    AdaptState *adapt = (AdaptState *)calloc(1, sizeof(AdaptState));
+    if (!adapt) return NULL;
     
-    mgmtData->frames = (Frame *)malloc(sizeof(Frame) * numPages);
-    if (!mgmtData->frames) { free(mgmtData); return RC_WRITE_FAILED; }
+    // sample 1 in 2^k pages with k as small as fits ADAPT_MAX_SHADOW entries
+    unsigned int sample = 1;
+    while (sample < ADAPT_MAX_SAMPLE && numFrames / (int)sample > ADAPT_MAX_SHADOW) sample *= 2;
+    adapt->sampleMask = sample - 1;
     
-    // Initialize frames
-    for (int i = 0; i < numPages; i++) {
-        mgmtData->frames[i].pageNum = NO_PAGE;
-        mgmtData->frames[i].data = (char *)malloc(PAGE_SIZE);
-        if (!mgmtData->frames[i].data) {
-            cleanupFrames(mgmtData, i);
-            free(mgmtData->frames);
-            free(mgmtData);
-            return RC_WRITE_FAILED;
+    for (int c = 0; c < RS_ADAPTIVE; c++) {
+        ShadowCache *sc = &adapt->shadows[c];
+        sc->capacity = numFrames / (int)sample;
+        sc->entries = (Frame *)calloc(sc->capacity, sizeof(Frame));
+        if (!sc->entries) {
+            while (c-- > 0) free(adapt->shadows[c].entries);
+            free(adapt);
+            return NULL;
         }
-        mgmtData->frames[i].dirty = false;
-        mgmtData->frames[i].fixCount = 0;
-        mgmtData->frames[i].lastAccessTime = 0;
-        mgmtData->frames[i].loadTime = 0;
-        mgmtData->frames[i].accessCount = 0;
-        mgmtData->frames[i].accessHistory = NULL;
-        mgmtData->frames[i].historySize = 0;
     }
-    
-    mgmtData->numFrames = numPages;
-    mgmtData->numReadIO = 0;
-    mgmtData->numWriteIO = 0;
-    mgmtData->clockHand = 0;
-    mgmtData->timeCounter = 0;
-    
-    mgmtData->fileHandle = (SM_FileHandle *)malloc(sizeof(SM_FileHandle));
-    if (!mgmtData->fileHandle) {
-        cleanupFrames(mgmtData, numPages);
-        free(mgmtData->frames);
-        free(mgmtData);
-        return RC_WRITE_FAILED;
+    return adapt;
+}
+
+static void destroyAdaptState(AdaptState *adapt) {
+    if (!adapt) return;
+    for (int c = 0; c < RS_ADAPTIVE; c++) {
+        for (int i = 0; i < adapt->shadows[c].capacity; i++)
+            free(adapt->shadows[c].entries[i].accessHistory);
+        free(adapt->shadows[c].entries);
     }
+    free(adapt);
+}
+
+// Helper: write frame to disk
+static RC writeFrameToDisk(BM_BufferPool *const bm, int frameIndex) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    Frame *frame = &mgmtData->frames[frameIndex];
     
-    RC rc = openPageFile(pageFileName, mgmtData->fileHandle);
-    if (rc != RC_OK) {
-        cleanupFrames(mgmtData, numPages);
-        free(mgmtData->frames);
-        free(mgmtData->fileHandle);
-        free(mgmtData);
-        return rc;
+    if (frame->dirty && frame->pageNum != NO_PAGE) {
+        // a page from pinNewPage may lie past the end of the file
+        if (frame->pageNum >= mgmtData->fileHandle->totalNumPages) {
+            int extentEnd = (frame->pageNum / NEW_PAGE_EXTENT + 1) * NEW_PAGE_EXTENT;
+            RC rc = ensureCapacity(extentEnd, mgmtData->fileHandle);
+            if (rc != RC_OK) return rc;
+        }
+        ET_BEGIN(traceStart);
+        long long start = nowNs();
+        RC rc = writeBlock(frame->pageNum, mgmtData->fileHandle, frame->data);
+        if (rc != RC_OK) return rc;
+        // any L2 copy is older than what was just written
+        dropL2Page(mgmtData->l2Cache, frame->pageNum);
+        clearFrameDirty(mgmtData, frameIndex);
+        BM_PoolStats *stats = &mgmtData->stats;
+        stats->writeIO++;
+        stats->writeLatency[latencyBucket(nowNs() - start)]++;
+        if (frame->partition >= 0) mgmtData->partitions[frame->partition].stats.writeIO++;
+        ET_END(ET_WRITE_FRAME, frame->pageNum, frameIndex, traceStart);
     }
     return RC_OK;
 }
 
-// Shutdown buffer pool
-RC shutdownBufferPool(BM_BufferPool *const bm) {
-    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+// Helper: uncharge an emptied frame from its partition
+static void releaseFrame(BM_MgmtData *mgmtData, int frameIndex) {
+    Frame *frame = &mgmtData->frames[frameIndex];
+    if (frame->partition >= 0) mgmtData->partitions[frame->partition].frames--;
+    frame->partition = -1;
+    if (frame->priority != BM_PRIORITY_NORMAL) mgmtData->numPriorityFrames--;
+    frame->priority = BM_PRIORITY_NORMAL;
+    if (frame->sticky) mgmtData->numSticky--;
+    frame->sticky = false;
+}
+
+// Helper: apply a pin's priority to its frame. HIGH sticks until eviction;
+// LOW marks a page only scans asked for, until a normal pin wants it too.
+static void applyPriority(BM_MgmtData *mgmtData, int frameIndex, BM_PinPriority priority) {
+    Frame *frame = &mgmtData->frames[frameIndex];
+    if (frame->priority == priority || frame->priority == BM_PRIORITY_HIGH) return;
+    if (priority == BM_PRIORITY_NORMAL) {
+        if (frame->priority == BM_PRIORITY_LOW) mgmtData->numPriorityFrames--;
+    } else if (frame->priority == BM_PRIORITY_NORMAL) {
+        mgmtData->numPriorityFrames++;
+    }
+    frame->priority = priority;
+}
+
+// Helper: charge a claimed frame to the partition being pinned for
+static void chargeFrame(BM_MgmtData *mgmtData, int frameIndex) {
+    Frame *frame = &mgmtData->frames[frameIndex];
+    frame->partition = mgmtData->pinPartition;
+    mgmtData->partitions[frame->partition].frames++;
+}
+
+// Helper: write back a victim frame and hand its page to the victim cache
+static RC evictFrame(BM_BufferPool *const bm, int frameIndex) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    Frame *frame = &mgmtData->frames[frameIndex];
     
+    bool wasDirty = frame->dirty;
+    RC rc = writeFrameToDisk(bm, frameIndex);
+    if (rc != RC_OK) return rc;
+    if (frame->pageNum != NO_PAGE) {
+        if (wasDirty) mgmtData->stats.dirtyEvictions++;
+        else mgmtData->stats.cleanEvictions++;
+    }
+    if (frame->pageNum != NO_PAGE && mgmtData->victimCache)
+        putVictimPage(mgmtData->victimCache, frame->pageNum, frame->data);
+    if (frame->pageNum != NO_PAGE && mgmtData->l2Cache)
+        putL2Page(mgmtData->l2Cache, frame->pageNum, frame->data);
+    if (frame->pageNum != NO_PAGE && frame->partition >= 0)
+        mgmtData->partitions[frame->partition].stats.evictions++;
+    setFramePage(mgmtData, frameIndex, NO_PAGE);
+    releaseFrame(mgmtData, frameIndex);
+    return RC_OK;
+}
+
+// Helper: fill a frame with a page, from the victim cache if possible
+static RC loadPageIntoFrame(BM_BufferPool *const bm, int frameIndex, PageNumber pageNum) {
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    Frame *frame = &mgmtData->frames[frameIndex];
     
-    for (int i = 0; i < mgmtData->numFrames; i++)
-        if (mgmtData->frames[i].pageNum != NO_PAGE && mgmtData->frames[i].dirty)
-            writeFrameToDisk(bm, i);
+    if (mgmtData->victimCache) {
+        if (takeVictimPage(mgmtData->victimCache, pageNum, frame->data)) {
+            mgmtData->stats.victimCacheHits++;
+            return RC_OK;
+        }
+        mgmtData->stats.victimCacheMisses++;
+    }
     
-    if (mgmtData->fileHandle) {
-        closePageFile(mgmtData->fileHandle);
-        free(mgmtData->fileHandle);
+    if (mgmtData->l2Cache) {
+        if (getL2Page(mgmtData->l2Cache, pageNum, frame->data)) {
+            mgmtData->stats.l2Hits++;
+            return RC_OK;
+        }
+        mgmtData->stats.l2Misses++;
     }
     
-    cleanupFrames(mgmtData, mgmtData->numFrames);
-    free(mgmtData->frames);
-    free(mgmtData);
-    bm->mgmtData = NULL;
+    long long start = nowNs();
+    RC rc = readBlock(pageNum, mgmtData->fileHandle, frame->data);
+    if (rc != RC_OK) return rc;
+    BM_PoolStats *stats = &mgmtData->stats;
+    stats->readIO++;
+    stats->readLatency[latencyBucket(nowNs() - start)]++;
+    mgmtData->partitions[mgmtData->pinPartition].stats.readIO++;
     return RC_OK;
 }
 
-// Force flush all dirty pages
-RC forceFlushPool(BM_BufferPool *const bm) {
-    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
-    
+// Helper: victim frame within one partition, or -1
+static int selectVictimIn(BM_BufferPool *const bm, int partition) {
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
-    for (int i = 0; i < mgmtData->numFrames; i++)
-        if (mgmtData->frames[i].pageNum != NO_PAGE && mgmtData->frames[i].dirty) {
-            RC rc = writeFrameToDisk(bm, i);
-            if (rc != RC_OK) return rc;
-        }
-    return RC_OK;
+    mgmtData->victimPartition = partition;
+    int victim = selectVictimFrame(bm);
+    mgmtData->victimPartition = -1;
+    return victim;
 }
 
-// Pin a page
-RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
-    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
-    if (pageNum < 0) return RC_READ_NON_EXISTING_PAGE;
+// Helper: victim for a pin charged to partition part. Partitions over their
+// maximum give up frames first, then those over their minimum, largest excess
+// first; a partition at its maximum, or with nobody else to take from,
+// replaces its own pages. The cost grows with the number of partitions, not
+// frames, on top of the strategy's own scan.
+static int selectPartitionVictim(BM_BufferPool *const bm, int part) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    BM_Partition *parts = mgmtData->partitions;
     
+    if (parts[part].frames < parts[part].maxFrames) {
+        for (int pass = 0; pass < 2; pass++) {
+            bool tried[BM_MAX_PARTITIONS] = { false };
+            for (;;) {
+                int best = -1, bestExcess = 0;
+                for (int q = 0; q < BM_MAX_PARTITIONS; q++) {
+                    if (!parts[q].used || q == part || tried[q]) continue;
+                    int excess = parts[q].frames - (pass == 0 ? parts[q].maxFrames : parts[q].minFrames);
+                    if (excess > bestExcess) { best = q; bestExcess = excess; }
+                }
+                if (best < 0) break;
+                tried[best] = true;
+                int victim = selectVictimIn(bm, best);
+                if (victim >= 0) return victim;
+            }
+        }
+    }
+    return selectVictimIn(bm, part);
+}
+
+// Helper: next unpinned transient frame, or -1 if all are pinned
+static int takeTransientFrame(BM_MgmtData *mgmtData) {
+    for (int n = 0; n < BM_TRANSIENT_FRAMES; n++) {
+        int i = mgmtData->numFrames + (mgmtData->transientHand + n) % BM_TRANSIENT_FRAMES;
+        if (mgmtData->frames[i].fixCount > 0 || mgmtData->frames[i].sticky) continue;
+        mgmtData->transientHand = (i - mgmtData->numFrames + 1) % BM_TRANSIENT_FRAMES;
+        return i;
+    }
+    return -1;
+}
+
+// Helper: take a free frame, or evict a victim from the main pool, and
+// charge it to the pinning partition. With the admission filter on, a page
+// (pageNum, NO_PAGE if unknown) that is not more frequent than the victim
+// goes to a transient frame instead.
+static RC claimFrame(BM_BufferPool *const bm, PageNumber pageNum, int *claimedFrame) {
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
-    int frameIndex = findFrame(mgmtData, pageNum);
+    BM_Partition *part = &mgmtData->partitions[mgmtData->pinPartition];
     
-    if (frameIndex >= 0) {
-        // Page already in buffer
-        Frame *frame = &mgmtData->frames[frameIndex];
-        frame->fixCount++;
-        mgmtData->timeCounter++;
-        
-        if (bm->strategy == RS_LRU) frame->lastAccessTime = mgmtData->timeCounter;
-        if (bm->strategy == RS_LFU) frame->accessCount++;
-        if (bm->strategy == RS_LRU_K) updateLRUKHistory(frame, mgmtData->timeCounter, 2);
-        
-        page->pageNum = pageNum;
-        page->data = frame->data;
-        return RC_OK;
+    int frameIndex = -1;
+    if (mgmtData->numPartitions <= 1) {
+        frameIndex = findEmptyFrame(mgmtData);
+        if (frameIndex < 0) frameIndex = selectVictimFrame(bm);
+    } else {
+        if (part->frames < part->maxFrames) frameIndex = findEmptyFrame(mgmtData);
+        if (frameIndex < 0) frameIndex = selectPartitionVictim(bm, mgmtData->pinPartition);
     }
+    mgmtData->noVictim = (frameIndex < 0);
+    if (frameIndex < 0) return RC_WRITE_FAILED;
     
-    // Page not in buffer - load it
-    frameIndex = findEmptyFrame(mgmtData);
-    if (frameIndex < 0) {
-        frameIndex = selectVictimFrame(bm);
-        if (frameIndex < 0) return RC_WRITE_FAILED;
-        RC rc = writeFrameToDisk(bm, frameIndex);
-        if (rc != RC_OK) return rc;
+    if (mgmtData->admission && pageNum != NO_PAGE && mgmtData->frames[frameIndex].pageNum != NO_PAGE &&
+        estimatePageFrequency(mgmtData->admission, pageNum) <=
+        estimatePageFrequency(mgmtData->admission, mgmtData->frames[frameIndex].pageNum)) {
+        int transient = takeTransientFrame(mgmtData);
+        if (transient >= 0) {
+            mgmtData->stats.admissionRejects++;
+            RC rc = evictFrame(bm, transient);
+            if (rc != RC_OK) return rc;
+            *claimedFrame = transient;
+            return RC_OK;
+        }
     }
     
-    Frame *frame = &mgmtData->frames[frameIndex];
-    RC rc = readBlock(pageNum, mgmtData->fileHandle, frame->data);
+    commitVictim(mgmtData, frameIndex);
+    RC rc = evictFrame(bm, frameIndex);
     if (rc != RC_OK) return rc;
+    chargeFrame(mgmtData, frameIndex);
+    *claimedFrame = frameIndex;
+    return RC_OK;
+}
+
+// Helper: set up a freshly filled frame as an unpinned, clean page
+static void installUnpinned(BM_BufferPool *const bm, int frameIndex, PageNumber pageNum) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    Frame *frame = &mgmtData->frames[frameIndex];
     
-    mgmtData->numReadIO++;
     mgmtData->timeCounter++;
-    
-    frame->pageNum = pageNum;
+    setFramePage(mgmtData, frameIndex, pageNum);
     frame->dirty = false;
-    frame->fixCount = 1;
+    frame->fixCount = 0;
+    frame->ringFrame = false;
     frame->lastAccessTime = mgmtData->timeCounter;
     frame->loadTime = mgmtData->timeCounter;
     frame->accessCount = 1;
+    frame->historySize = 0;
+    if (tracksStrategy(bm, RS_LRU_K)) updateLRUKHistory(frame, mgmtData->timeCounter, 2);
+}
+
+// Helper: load count consecutive pages into unpinned frames with one read
+// through staging, which holds count pages; frames[i] receives the frame of
+// firstPage + i. The pages must not be resident.
+static RC loadRunUnpinned(BM_BufferPool *const bm, PageNumber firstPage, int count,
+                          char *staging, int *frames) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    
+    long long start = nowNs();
+    RC rc = readBlocks(firstPage, count, mgmtData->fileHandle, staging);
+    if (rc != RC_OK) return rc;
+    BM_PoolStats *stats = &mgmtData->stats;
+    stats->readIO += count;
+    stats->readLatency[latencyBucket((nowNs() - start) / count)] += count;
+    
+    for (int i = 0; i < count; i++) {
+        rc = claimFrame(bm, NO_PAGE, &frames[i]);
+        if (rc != RC_OK) return rc;
+        // the disk copy is current, a compressed one would only go stale
+        if (mgmtData->victimCache) dropVictimPage(mgmtData->victimCache, firstPage + i);
+        memcpy(mgmtData->frames[frames[i]].data, staging + (size_t)i * mgmtData->pageSize,
+               mgmtData->pageSize);
+        installUnpinned(bm, frames[i], firstPage + i);
+    }
+    return RC_OK;
+}
+
+// Unpinned loads read runs of up to this many bytes at once
+#define LOAD_RUN_BYTES (256 * 1024)
+
+// Helper: pages per unpinned load run for this pool
+static int loadRunPages(BM_MgmtData *mgmtData) {
+    int pages = LOAD_RUN_BYTES / mgmtData->pageSize;
+    return pages > 0 ? pages : 1;
+}
+
+// Warm restart sidecar: magic, version, entry count, time counter, then one
+// WarmEntry per resident page (native byte order, it never leaves the host)
+#define WARM_MAGIC "BMWR"
+#define WARM_VERSION 1
+
+typedef struct WarmEntry {
+    PageNumber pageNum;
+    int lastAccessTime;
+    int loadTime;
+    int accessCount;
+    int historySize;
+    int history[2];
+} WarmEntry;
+
+// Helper: sidecar file name of a page file
+static char *warmFileName(const char *pageFile) {
+    char *name = (char *)malloc(strlen(pageFile) + 6);
+    if (name) sprintf(name, "%s.warm", pageFile);
+    return name;
+}
+
+static int compareWarmEntries(const void *a, const void *b) {
+    return ((const WarmEntry *)a)->pageNum - ((const WarmEntry *)b)->pageNum;
+}
+
+typedef struct WarmRank {
+    long long key;              // strategy rank, then recency
+    int index;
+} WarmRank;
+
+// Helper: how much a saved page is worth keeping, by the rank frameRank
+// would give its frame (CLOCK, which has none, by recency)
+static long long warmKey(ReplacementStrategy strategy, const WarmEntry *e) {
+    long long rank;
+    switch (strategy) {
+        case RS_FIFO: rank = e->loadTime; break;
+        case RS_LFU: case RS_SAMPLED_LFU: rank = e->accessCount; break;
+        case RS_LRU_K: rank = (e->historySize >= 2) ? e->history[0] : 0; break;
+        default: rank = e->lastAccessTime; break;
+    }
+    return (rank << 32) + (unsigned int)e->lastAccessTime;
+}
+
+static int compareWarmRanks(const void *a, const void *b) {
+    long long x = ((const WarmRank *)a)->key, y = ((const WarmRank *)b)->key;
+    return (x < y) - (x > y);
+}
+
+// Helper: move the keep entries the strategy values most to the front
+static void keepBestWarmEntries(ReplacementStrategy strategy, WarmEntry *entries, int count, int keep) {
+    WarmRank *ranks = (WarmRank *)malloc(sizeof(WarmRank) * count);
+    WarmEntry *kept = (WarmEntry *)malloc(sizeof(WarmEntry) * keep);
+    if (ranks && kept) {
+        for (int i = 0; i < count; i++) {
+            ranks[i].key = warmKey(strategy, &entries[i]);
+            ranks[i].index = i;
+        }
+        qsort(ranks, count, sizeof(WarmRank), compareWarmRanks);
+        for (int i = 0; i < keep; i++) kept[i] = entries[ranks[i].index];
+        memcpy(entries, kept, sizeof(WarmEntry) * keep);
+    }
+    free(ranks);
+    free(kept);
+}
+
+// Helper: write the resident page list with its replacement metadata
+static RC saveWarmRestart(BM_BufferPool *const bm) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    char *name = warmFileName(bm->pageFile);
+    if (!name) return RC_WRITE_FAILED;
+    FILE *fp = fopen(name, "wb");
+    if (!fp) {
+        free(name);
+        return RC_WRITE_FAILED;
+    }
+    
+    int header[3] = { WARM_VERSION, 0, mgmtData->timeCounter };
+    for (int i = 0; i < mgmtData->numFrames; i++)
+        if (mgmtData->frames[i].pageNum != NO_PAGE) header[1]++;
+    bool ok = fwrite(WARM_MAGIC, 1, 4, fp) == 4 && fwrite(header, sizeof(int), 3, fp) == 3;
+    
+    for (int i = 0; ok && i < mgmtData->numFrames; i++) {
+        Frame *frame = &mgmtData->frames[i];
+        if (frame->pageNum == NO_PAGE) continue;
+        WarmEntry e = { frame->pageNum, frame->lastAccessTime, frame->loadTime,
+                        frame->accessCount, frame->historySize, { 0, 0 } };
+        for (int k = 0; k < frame->historySize && k < 2; k++) e.history[k] = frame->accessHistory[k];
+        ok = fwrite(&e, sizeof(WarmEntry), 1, fp) == 1;
+    }
+    ok = (fclose(fp) == 0) && ok;
+    // a truncated list would reload a partial pool; better none at all
+    if (!ok) remove(name);
+    free(name);
+    return ok ? RC_OK : RC_WRITE_FAILED;
+}
+
+// Helper: reload the pages listed in a warm restart sidecar, in page order
+static void loadWarmRestart(BM_BufferPool *const bm) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    char magic[4];
+    int header[3];
+    
+    char *name = warmFileName(bm->pageFile);
+    if (!name) return;
+    FILE *fp = fopen(name, "rb");
+    if (!fp) { free(name); return; }
+    
+    if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, WARM_MAGIC, 4) != 0 ||
+        fread(header, sizeof(int), 3, fp) != 3 || header[0] != WARM_VERSION || header[1] <= 0) {
+        fclose(fp);
+        free(name);
+        return;
+    }
+    
+    int count = header[1];
+    WarmEntry *entries = (WarmEntry *)malloc(sizeof(WarmEntry) * count);
+    if (entries) count = (int)fread(entries, sizeof(WarmEntry), count, fp);
+    fclose(fp);
+    // the list is consumed; a stale one must not outlive this pool
+    remove(name);
+    free(name);
+    if (!entries) return;
+    
+    // a smaller pool keeps the pages its strategy values most; sorted page
+    // order then turns runs of adjacent pages into single reads
+    if (count > mgmtData->numFrames) {
+        keepBestWarmEntries(mgmtData->liveStrategy, entries, count, mgmtData->numFrames);
+        count = mgmtData->numFrames;
+    }
+    qsort(entries, count, sizeof(WarmEntry), compareWarmEntries);
+    
+    int maxRun = loadRunPages(mgmtData);
+    char *staging = (char *)malloc((size_t)maxRun * mgmtData->pageSize);
+    int *frames = (int *)malloc(sizeof(int) * maxRun);
+    for (int i = 0, run; staging && frames && i < count; i += run) {
+        run = 1;
+        if (entries[i].pageNum < 0 || entries[i].pageNum >= mgmtData->fileHandle->totalNumPages) continue;
+        if (findFrame(mgmtData, entries[i].pageNum) >= 0) continue;
+        while (run < maxRun && i + run < count &&
+               entries[i + run].pageNum == entries[i].pageNum + run &&
+               entries[i + run].pageNum < mgmtData->fileHandle->totalNumPages &&
+               findFrame(mgmtData, entries[i + run].pageNum) < 0)
+            run++;
+        if (loadRunUnpinned(bm, entries[i].pageNum, run, staging, frames) != RC_OK) break;
+        
+        for (int r = 0; r < run; r++) {
+            const WarmEntry *e = &entries[i + r];
+            Frame *frame = &mgmtData->frames[frames[r]];
+            frame->lastAccessTime = e->lastAccessTime;
+            frame->loadTime = e->loadTime;
+            frame->accessCount = e->accessCount;
+            frame->historySize = 0;
+            for (int k = 0; k < e->historySize && k < 2; k++)
+                updateLRUKHistory(frame, e->history[k], 2);
+        }
+    }
+    if (mgmtData->timeCounter < header[2]) mgmtData->timeCounter = header[2];
+    free(staging);
+    free(frames);
+    free(entries);
+}
+
+// Helper: cleanup frames
+static void cleanupFrames(BM_MgmtData *mgmtData, int numFrames) {
+    for (int i = 0; i < numFrames; i++) {
+        free(mgmtData->frames[i].data);
+        free(mgmtData->frames[i].accessHistory);
+    }
+}
+
+// Helper: undo a failed initBufferPool once the file is open and
+// numFrames frames have their page buffers
+static RC abortInit(BM_BufferPool *const bm, int numFrames) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (mgmtData->frames) {
+        cleanupFrames(mgmtData, numFrames);
+        free(mgmtData->frames);
+    }
+    free(mgmtData->pageBuckets);
+    free(mgmtData->pageChain);
+    closePageFile(mgmtData->fileHandle);
+    free(mgmtData->fileHandle);
+    free(mgmtData);
+    bm->mgmtData = NULL;
+    return RC_WRITE_FAILED;
+}
+
+// Initialize buffer pool
+RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
+                  const int numPages, ReplacementStrategy strategy, void *stratData) {
+    if (!bm || !pageFileName) return RC_FILE_NOT_FOUND;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)malloc(sizeof(BM_MgmtData));
+    if (!mgmtData) return RC_WRITE_FAILED;
+    
+    // the file's page size is the frame size, so open it first
+    mgmtData->fileHandle = (SM_FileHandle *)malloc(sizeof(SM_FileHandle));
+    if (!mgmtData->fileHandle) {
+        free(mgmtData);
+        return RC_WRITE_FAILED;
+    }
+    
+    RC rc = openPageFile(pageFileName, mgmtData->fileHandle);
+    if (rc != RC_OK) {
+        free(mgmtData->fileHandle);
+        free(mgmtData);
+        return rc;
+    }
+    mgmtData->pageSize = mgmtData->fileHandle->pageSize;
+    
+    bm->pageFile = (char *)pageFileName;
+    bm->numPages = numPages;
+    bm->strategy = strategy;
+    bm->mgmtData = mgmtData;
+    
+    // the transient frames get their page buffers with the admission filter
+    int numSlots = numPages + BM_TRANSIENT_FRAMES;
+    mgmtData->frames = (Frame *)malloc(sizeof(Frame) * numSlots);
+    unsigned int numBuckets = 64;
+    while (numBuckets < (unsigned)numPages) numBuckets <<= 1;
+    mgmtData->pageBuckets = (int *)malloc(sizeof(int) * numBuckets);
+    mgmtData->pageChain = (int *)malloc(sizeof(int) * numSlots);
+    if (!mgmtData->frames || !mgmtData->pageBuckets || !mgmtData->pageChain) return abortInit(bm, 0);
+    mgmtData->bucketMask = numBuckets - 1;
+    for (unsigned int b = 0; b < numBuckets; b++) mgmtData->pageBuckets[b] = -1;
+    mgmtData->numEmpty = numPages;
+    mgmtData->emptyHint = 0;
+    
+    // Initialize frames
+    for (int i = 0; i < numSlots; i++) {
+        mgmtData->frames[i].pageNum = NO_PAGE;
+        mgmtData->pageChain[i] = -1;
+        mgmtData->frames[i].data = (i < numPages) ? (char *)malloc(mgmtData->pageSize) : NULL;
+        if (i < numPages && !mgmtData->frames[i].data) return abortInit(bm, i);
+        mgmtData->frames[i].dirty = false;
+        mgmtData->frames[i].fixCount = 0;
+        mgmtData->frames[i].ringFrame = false;
+        mgmtData->frames[i].lastAccessTime = 0;
+        mgmtData->frames[i].loadTime = 0;
+        mgmtData->frames[i].accessCount = 0;
+        mgmtData->frames[i].accessHistory = NULL;
+        mgmtData->frames[i].historySize = 0;
+        mgmtData->frames[i].dirtySeq = 0;
+        mgmtData->frames[i].dirtyPrev = -1;
+        mgmtData->frames[i].dirtyNext = -1;
+        mgmtData->frames[i].partition = -1;
+        mgmtData->frames[i].priority = BM_PRIORITY_NORMAL;
+        mgmtData->frames[i].sticky = false;
+    }
+    
+    mgmtData->numFrames = numPages;
+    memset(&mgmtData->stats, 0, sizeof(mgmtData->stats));
+    mgmtData->clockHand = 0;
+    mgmtData->timeCounter = 0;
+    mgmtData->liveStrategy = (strategy == RS_ADAPTIVE) ? RS_LRU : strategy;
+    mgmtData->adapt = NULL;
+    if (strategy == RS_ADAPTIVE) {
+        mgmtData->adapt = createAdaptState(numPages);
+        if (!mgmtData->adapt) return abortInit(bm, numPages);
+    }
+    mgmtData->victimCache = NULL;
+    mgmtData->l2Cache = NULL;
+    mgmtData->admission = NULL;
+    mgmtData->transientHand = 0;
+    mgmtData->missRatio = NULL;
+    mgmtData->warmRestart = false;
+    mgmtData->accessTrace = NULL;
+    mgmtData->dirtyHead = -1;
+    mgmtData->dirtyTail = -1;
+    mgmtData->numDirty = 0;
+    mgmtData->dirtyCounter = 0;
+    mgmtData->checkpointActive = false;
+    mgmtData->checkpointPaused = false;
+    mgmtData->checkpointHorizon = 0;
+    mgmtData->pagesPerSecond = 0;
+    mgmtData->checkpointTokens = 0;
+    mgmtData->checkpointRefillNs = 0;
+    mgmtData->nextNewPage = mgmtData->fileHandle->totalNumPages;
+    mgmtData->evictionWindow = 0;
+    mgmtData->candidates = NULL;
+    mgmtData->sampleSize = BM_DEFAULT_SAMPLE_SIZE;
+    mgmtData->sampleSeed = 2463534242u;
+    mgmtData->samplePoolCount = 0;
+    memset(mgmtData->partitions, 0, sizeof(mgmtData->partitions));
+    mgmtData->partitions[0].used = true;
+    strcpy(mgmtData->partitions[0].name, "default");
+    mgmtData->partitions[0].maxFrames = numPages;
+    mgmtData->numPartitions = 1;
+    mgmtData->pinPartition = 0;
+    mgmtData->victimPartition = -1;
+    mgmtData->pinPriority = BM_PRIORITY_NORMAL;
+    mgmtData->numPriorityFrames = 0;
+    mgmtData->numSticky = 0;
+    mgmtData->stickyLimit = (int)(numPages * BM_DEFAULT_STICKY_FRACTION);
+    mgmtData->concurrent = false;
+    mgmtData->pinWaitMs = 0;
+    mgmtData->waitHead = NULL;
+    mgmtData->waitTail = NULL;
+    mgmtData->noVictim = false;
+    mgmtData->pinRetry = false;
+    
+    loadWarmRestart(bm);
+    return RC_OK;
+}
+
+// Shutdown buffer pool
+RC shutdownBufferPool(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    
+    while (mgmtData->dirtyHead >= 0)
+        if (writeFrameToDisk(bm, mgmtData->dirtyHead) != RC_OK) break;
+    
+    if (mgmtData->warmRestart) saveWarmRestart(bm);
+    
+    if (mgmtData->fileHandle) {
+        closePageFile(mgmtData->fileHandle);
+        free(mgmtData->fileHandle);
+    }
+    
+    if (mgmtData->accessTrace) closeAccessTraceWriter(mgmtData->accessTrace);
+    destroyVictimCache(mgmtData->victimCache);
+    destroyL2Cache(mgmtData->l2Cache);
+    free(mgmtData->candidates);
+    free(mgmtData->pageBuckets);
+    free(mgmtData->pageChain);
+    destroyAdaptState(mgmtData->adapt);
+    if (mgmtData->concurrent) pthread_mutex_destroy(&mgmtData->poolLock);
+    destroyFreqSketch(mgmtData->admission);
+    destroyMissRatioTracker(mgmtData->missRatio);
+    cleanupFrames(mgmtData, mgmtData->numFrames + BM_TRANSIENT_FRAMES);
+    free(mgmtData->frames);
+    free(mgmtData);
+    bm->mgmtData = NULL;
+    return RC_OK;
+}
+
+// Force flush all dirty pages
+// Helper: forceFlushPool under the pool lock
+static RC flushDirtyFrames(BM_BufferPool *const bm) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    RC rc = RC_OK;
+    mgmtData->stats.flushes++;
+    while (mgmtData->dirtyHead >= 0 && rc == RC_OK) {
+        rc = writeFrameToDisk(bm, mgmtData->dirtyHead);
+        if (rc == RC_OK) mgmtData->stats.flushedPages++;
+    }
+    if (rc == RC_OK) mgmtData->checkpointActive = false;
+    return rc;
+}
+
+RC forceFlushPool(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    RC rc = flushDirtyFrames(bm);
+    unlockPool(mgmtData);
+    return rc;
+}
+
+// Online backup: the flush and the copy run under the pool lock, so the
+// backup holds every page as of one point and in-pool writers wait for it
+RC backupPool(BM_BufferPool *const bm, const char *backupFileName, bool incremental) {
+    if (!bm || !bm->mgmtData || !backupFileName) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    RC rc = flushDirtyFrames(bm);
+    if (rc == RC_OK) rc = backupPageFile(mgmtData->fileHandle, (char *)backupFileName, incremental);
+    unlockPool(mgmtData);
+    return rc;
+}
+
+// Helper: write the checkpoint pages the token bucket allows. The dirty list
+// is ordered by first-dirty time, so eligible pages are always at its head.
+static RC checkpointTick(BM_BufferPool *const bm) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (!mgmtData->checkpointActive || mgmtData->checkpointPaused) return RC_OK;
+    
+    if (mgmtData->pagesPerSecond > 0) {
+        // refill, keeping at most a tenth of a second (and one page) of burst
+        long long now = nowNs();
+        double burst = mgmtData->pagesPerSecond / 10.0;
+        if (burst < 1) burst = 1;
+        mgmtData->checkpointTokens += (now - mgmtData->checkpointRefillNs) * 1e-9 * mgmtData->pagesPerSecond;
+        if (mgmtData->checkpointTokens > burst) mgmtData->checkpointTokens = burst;
+        mgmtData->checkpointRefillNs = now;
+    }
+    
+    while (mgmtData->dirtyHead >= 0 &&
+           mgmtData->frames[mgmtData->dirtyHead].dirtySeq <= mgmtData->checkpointHorizon) {
+        if (mgmtData->pagesPerSecond > 0) {
+            if (mgmtData->checkpointTokens < 1) return RC_OK;
+            mgmtData->checkpointTokens -= 1;
+        }
+        RC rc = writeFrameToDisk(bm, mgmtData->dirtyHead);
+        if (rc != RC_OK) return rc;
+        mgmtData->stats.checkpointPages++;
+    }
+    mgmtData->checkpointActive = false;
+    return RC_OK;
+}
+
+// Helper: take the next frame of an access strategy ring, or -1 to fall back
+// to the main pool. A ring slot is reusable only while its frame still holds
+// an unpinned page that was loaded through a ring.
+static int nextRingFrame(BM_MgmtData *mgmtData, BM_AccessStrategy *strat) {
+    int slot = strat->current;
+    strat->current = (strat->current + 1) % strat->ringSize;
+    
+    int frameIndex = strat->frames[slot];
+    if (frameIndex < 0) return -1;
+    Frame *frame = &mgmtData->frames[frameIndex];
+    if (!frame->ringFrame || frame->fixCount > 0 || frame->sticky) return -1;
+    return frameIndex;
+}
+
+// Helper: pin a page, recycling frames through strat's ring when given
+static RC pinPageFrame(BM_BufferPool *const bm, BM_PageHandle *const page,
+                       const PageNumber pageNum, BM_AccessStrategy *strat, int *pinnedFrame) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (pageNum < 0) return RC_READ_NON_EXISTING_PAGE;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (!mgmtData->pinRetry) {
+        if (mgmtData->accessTrace) writeAccessRecord(mgmtData->accessTrace, AT_PIN, pageNum);
+        if (mgmtData->adapt) adaptObserve(bm, pageNum);
+        if (mgmtData->admission) recordPageAccess(mgmtData->admission, pageNum);
+        if (mgmtData->missRatio) recordMissRatioAccess(mgmtData->missRatio, pageNum);
+    }
+    int frameIndex = findFrame(mgmtData, pageNum);
+    
+    if (frameIndex >= 0) {
+        // Page already in buffer
+        Frame *frame = &mgmtData->frames[frameIndex];
+        mgmtData->stats.hits++;
+        mgmtData->partitions[mgmtData->pinPartition].stats.hits++;
+        frame->fixCount++;
+        mgmtData->timeCounter++;
+        
+        // a regular pin adopts a scan page into the main pool
+        if (frame->ringFrame && !strat) {
+            frame->ringFrame = false;
+            frame->loadTime = mgmtData->timeCounter;
+        }
+        if (tracksStrategy(bm, RS_LRU)) frame->lastAccessTime = mgmtData->timeCounter;
+        if (tracksStrategy(bm, RS_LFU)) frame->accessCount++;
+        if (tracksStrategy(bm, RS_LRU_K)) updateLRUKHistory(frame, mgmtData->timeCounter, 2);
+        
+        page->pageNum = pageNum;
+        page->data = frame->data;
+        *pinnedFrame = frameIndex;
+        return RC_OK;
+    }
+    
+    // Page not in buffer - load it; a waiter's retries are the same miss
+    if (!mgmtData->pinRetry) {
+        mgmtData->stats.misses++;
+        mgmtData->partitions[mgmtData->pinPartition].stats.misses++;
+    }
+    int ringSlot = -1;
+    frameIndex = -1;
+    if (strat) {
+        frameIndex = nextRingFrame(mgmtData, strat);
+        ringSlot = (strat->current + strat->ringSize - 1) % strat->ringSize;
+    }
+    RC rc;
+    if (frameIndex >= 0) {
+        rc = evictFrame(bm, frameIndex);
+        if (rc == RC_OK) chargeFrame(mgmtData, frameIndex);
+    } else {
+        rc = claimFrame(bm, pageNum, &frameIndex);
+    }
+    if (rc != RC_OK) return rc;
+    
+    Frame *frame = &mgmtData->frames[frameIndex];
+    rc = loadPageIntoFrame(bm, frameIndex, pageNum);
+    if (rc != RC_OK) {
+        releaseFrame(mgmtData, frameIndex);
+        return rc;
+    }
+    
+    mgmtData->timeCounter++;
+    
+    setFramePage(mgmtData, frameIndex, pageNum);
+    frame->dirty = false;
+    frame->fixCount = 1;
+    frame->ringFrame = (strat != NULL);
+    frame->lastAccessTime = mgmtData->timeCounter;
+    frame->loadTime = mgmtData->timeCounter;
+    frame->accessCount = 1;
+    
+    if (tracksStrategy(bm, RS_LRU_K)) {
+        frame->historySize = 0;
+        updateLRUKHistory(frame, mgmtData->timeCounter, 2);
+    }
+    
+    if (strat) {
+        // scan pages rank oldest, so the main pool also gives them up first
+        strat->frames[ringSlot] = frameIndex;
+        frame->lastAccessTime = 0;
+        frame->loadTime = 0;
+        frame->accessCount = 0;
+    }
+    
+    page->pageNum = pageNum;
+    page->data = frame->data;
+    *pinnedFrame = frameIndex;
+    return RC_OK;
+}
+
+// Helper: whether a failed attempt should wait for an unpin
+static bool shouldWait(BM_MgmtData *mgmtData, RC rc) {
+    return rc == RC_WRITE_FAILED && mgmtData->noVictim && mgmtData->concurrent && mgmtData->pinWaitMs != 0;
+}
+
+// Helper: whether a frame-needing attempt must let earlier waiters go first
+static bool mustQueue(BM_MgmtData *mgmtData, BM_Waiter *self, bool queued) {
+    if (!mgmtData->concurrent) return false;
+    return queued ? mgmtData->waitHead != self : mgmtData->waitHead != NULL;
+}
+
+// Helper: join the wait queue if needed and sleep until woken or the
+// deadline; the pin in progress is restored after the lock is retaken
+static RC waitForFrame(BM_MgmtData *mgmtData, BM_Waiter *self, bool *queued,
+                       const struct timespec *deadline) {
+    if (!*queued) {
+        pthread_cond_init(&self->wake, NULL);
+        self->next = NULL;
+        if (mgmtData->waitTail) mgmtData->waitTail->next = self;
+        else mgmtData->waitHead = self;
+        mgmtData->waitTail = self;
+        *queued = true;
+    }
+    
+    int partition = mgmtData->pinPartition;
+    BM_PinPriority priority = mgmtData->pinPriority;
+    int err = (mgmtData->pinWaitMs < 0) ? pthread_cond_wait(&self->wake, &mgmtData->poolLock)
+                                        : pthread_cond_timedwait(&self->wake, &mgmtData->poolLock, deadline);
+    mgmtData->pinPartition = partition;
+    mgmtData->pinPriority = priority;
+    return (err == ETIMEDOUT) ? RC_PIN_TIMEOUT : RC_OK;
+}
+
+// Helper: leave the wait queue and give the next waiter its turn
+static void leaveWaitQueue(BM_MgmtData *mgmtData, BM_Waiter *self, long long waitStart, RC rc) {
+    BM_Waiter **link = &mgmtData->waitHead;
+    BM_Waiter *prev = NULL;
+    while (*link != self) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    *link = self->next;
+    if (mgmtData->waitTail == self) mgmtData->waitTail = prev;
+    pthread_cond_destroy(&self->wake);
+    if (mgmtData->waitHead) pthread_cond_signal(&mgmtData->waitHead->wake);
+    
+    BM_PoolStats *stats = &mgmtData->stats;
+    stats->pinWaits++;
+    if (rc == RC_PIN_TIMEOUT) stats->pinWaitTimeouts++;
+    stats->pinWaitLatency[latencyBucket(nowNs() - waitStart)]++;
+}
+
+// Helper: deadline for a pin that starts waiting now
+static struct timespec waitDeadline(BM_MgmtData *mgmtData) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (mgmtData->pinWaitMs > 0) {
+        long long ns = deadline.tv_nsec + (long long)(mgmtData->pinWaitMs % 1000) * 1000000LL;
+        deadline.tv_sec += mgmtData->pinWaitMs / 1000 + ns / 1000000000LL;
+        deadline.tv_nsec = ns % 1000000000LL;
+    }
+    return deadline;
+}
+
+// Helper: pin a page and count the pins that fail. In concurrent mode a miss
+// queues behind earlier waiters, and waits while every frame is pinned.
+static RC pinPageInternal(BM_BufferPool *const bm, BM_PageHandle *const page,
+                          const PageNumber pageNum, BM_AccessStrategy *strat,
+                          int partition, BM_PinPriority priority) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    int frameIndex = -1;
+    BM_Waiter self;
+    bool queued = false;
+    struct timespec deadline;
+    long long waitStart = 0;
+    RC rc;
+    
+    ET_BEGIN(start);
+    lockPool(mgmtData);
+    mgmtData->pinPartition = partition;
+    mgmtData->pinPriority = priority;
+    for (;;) {
+        // hits never wait: they take no frame from the waiters
+        if (!mustQueue(mgmtData, &self, queued) || findFrame(mgmtData, pageNum) >= 0) {
+            mgmtData->pinRetry = queued;
+            rc = pinPageFrame(bm, page, pageNum, strat, &frameIndex);
+            mgmtData->pinRetry = false;
+            if (!shouldWait(mgmtData, rc)) break;
+        }
+        if (!queued) {
+            waitStart = nowNs();
+            deadline = waitDeadline(mgmtData);
+        }
+        rc = waitForFrame(mgmtData, &self, &queued, &deadline);
+        if (rc != RC_OK) break;
+    }
+    if (queued) leaveWaitQueue(mgmtData, &self, waitStart, rc);
+    
+    if (rc != RC_OK)
+        mgmtData->stats.pinFailures++;
+    if (rc == RC_OK)
+        applyPriority(mgmtData, frameIndex, mgmtData->pinPriority);
+    mgmtData->pinPartition = 0;
+    mgmtData->pinPriority = BM_PRIORITY_NORMAL;
+    ET_END(ET_PIN_PAGE, pageNum, frameIndex, start);
+    unlockPool(mgmtData);
+    return rc;
+}
+
+// Pin a page
+RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
+    return pinPageInternal(bm, page, pageNum, NULL, 0, BM_PRIORITY_NORMAL);
+}
+
+// Helper: pinNewPage under the pool lock
+static RC pinNewPageInternal(BM_BufferPool *const bm, BM_PageHandle *const page, PageNumber *pageNum) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    int frameIndex;
+    BM_Waiter self;
+    bool queued = false;
+    struct timespec deadline;
+    long long waitStart = 0;
+    RC rc;
+    
+    for (;;) {
+        if (!mustQueue(mgmtData, &self, queued)) {
+            rc = claimFrame(bm, NO_PAGE, &frameIndex);
+            if (!shouldWait(mgmtData, rc)) break;
+        }
+        if (!queued) {
+            waitStart = nowNs();
+            deadline = waitDeadline(mgmtData);
+        }
+        rc = waitForFrame(mgmtData, &self, &queued, &deadline);
+        if (rc != RC_OK) break;
+    }
+    if (queued) leaveWaitQueue(mgmtData, &self, waitStart, rc);
+    if (rc != RC_OK) {
+        mgmtData->stats.pinFailures++;
+        return rc;
+    }
+    
+    // a page freed in the file is reused before the file grows
+    PageNumber newPage = mgmtData->nextNewPage;
+    if (getNumFreePages(mgmtData->fileHandle) > 0) {
+        int filePages = mgmtData->fileHandle->totalNumPages;
+        int reused;
+        if (allocatePage(&reused, mgmtData->fileHandle) == RC_OK && reused < filePages)
+            newPage = reused;
+    }
+    if (newPage == mgmtData->nextNewPage) mgmtData->nextNewPage++;
+    if (mgmtData->accessTrace) writeAccessRecord(mgmtData->accessTrace, AT_PIN, newPage);
+    mgmtData->stats.newPages++;
+    
+    Frame *frame = &mgmtData->frames[frameIndex];
+    mgmtData->timeCounter++;
+    memset(frame->data, 0, mgmtData->pageSize);
+    setFramePage(mgmtData, frameIndex, newPage);
+    frame->fixCount = 1;
+    frame->ringFrame = false;
+    frame->lastAccessTime = mgmtData->timeCounter;
+    frame->loadTime = mgmtData->timeCounter;
+    frame->accessCount = 1;
+    frame->historySize = 0;
+    if (tracksStrategy(bm, RS_LRU_K)) updateLRUKHistory(frame, mgmtData->timeCounter, 2);
+    setFrameDirty(mgmtData, frameIndex);
+    
+    page->pageNum = newPage;
+    page->data = frame->data;
+    *pageNum = newPage;
+    return RC_OK;
+}
+
+// Allocate a new page and pin it, zeroed and dirty, without reading it: a
+// page freed by deallocatePage if there is one, otherwise a page at the end
+// of the file, which grows when the page is first flushed
+RC pinNewPage(BM_BufferPool *const bm, BM_PageHandle *const page, PageNumber *pageNum) {
+    if (!bm || !bm->mgmtData || !page || !pageNum) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    RC rc = pinNewPageInternal(bm, page, pageNum);
+    unlockPool(mgmtData);
+    return rc;
+}
+
+// Set up a private frame ring for scans and bulk writes
+RC initAccessStrategy(BM_BufferPool *const bm, BM_AccessStrategy *const strat,
+                      BM_AccessHint hint, int ringSize) {
+    if (!bm || !bm->mgmtData || !strat) return RC_FILE_HANDLE_NOT_INIT;
+    
+    strat->hint = hint;
+    strat->current = 0;
+    strat->ringSize = 0;
+    strat->frames = NULL;
+    if (hint == BM_HINT_NORMAL) return RC_OK;
+    
+    if (ringSize <= 0)
+        ringSize = (hint == BM_HINT_BULK_WRITE) ? BM_BULK_WRITE_RING_SIZE : BM_SEQUENTIAL_RING_SIZE;
+    // never let one caller's ring take more than a quarter of the pool
+    if (ringSize > bm->numPages / 4) ringSize = bm->numPages / 4;
+    if (ringSize < 1) ringSize = 1;
     
-    if (bm->strategy == RS_LRU_K) {
-        frame->accessHistory = (int *)malloc(sizeof(int) * 2);
-        frame->historySize = 1;
-        frame->accessHistory[0] = mgmtData->timeCounter;
-    }
-    
-    page->pageNum = pageNum;
-    page->data = frame->data;
+    strat->frames = (int *)malloc(sizeof(int) * ringSize);
+    if (!strat->frames) return RC_WRITE_FAILED;
+    for (int i = 0; i < ringSize; i++) strat->frames[i] = -1;
+    strat->ringSize = ringSize;
+    return RC_OK;
+}
+
+RC freeAccessStrategy(BM_AccessStrategy *const strat) {
+    if (!strat) return RC_FILE_HANDLE_NOT_INIT;
+    free(strat->frames);
+    strat->frames = NULL;
+    strat->ringSize = 0;
     return RC_OK;
 }
 
+// Pin a page through an access strategy
+RC pinPageWithStrategy(BM_BufferPool *const bm, BM_PageHandle *const page,
+                       const PageNumber pageNum, BM_AccessStrategy *const strat) {
+    if (!strat || strat->hint == BM_HINT_NORMAL || strat->ringSize == 0)
+        return pinPageInternal(bm, page, pageNum, NULL, 0, BM_PRIORITY_NORMAL);
+    return pinPageInternal(bm, page, pageNum, strat, 0, BM_PRIORITY_NORMAL);
+}
+
 // Unpin a page
 RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page) {
     if (!bm || !bm->mgmtData || !page) return RC_FILE_HANDLE_NOT_INIT;
     
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    if (mgmtData->accessTrace) writeAccessRecord(mgmtData->accessTrace, AT_UNPIN, page->pageNum);
     int frameIndex = findFrame(mgmtData, page->pageNum);
-    if (frameIndex < 0) return RC_READ_NON_EXISTING_PAGE;
+    if (frameIndex < 0) {
+        unlockPool(mgmtData);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
     
-    if (mgmtData->frames[frameIndex].fixCount > 0)
-        mgmtData->frames[frameIndex].fixCount--;
+    Frame *frame = &mgmtData->frames[frameIndex];
+    if (frame->fixCount > 0 && --frame->fixCount == 0 && mgmtData->waitHead)
+        pthread_cond_signal(&mgmtData->waitHead->wake);
+    unlockPool(mgmtData);
     return RC_OK;
 }
 
@@ -284,11 +1644,12 @@ RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page) {
     if (!bm || !bm->mgmtData || !page) return RC_FILE_HANDLE_NOT_INIT;
     
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    if (mgmtData->accessTrace) writeAccessRecord(mgmtData->accessTrace, AT_MARK_DIRTY, page->pageNum);
     int frameIndex = findFrame(mgmtData, page->pageNum);
-    if (frameIndex < 0) return RC_READ_NON_EXISTING_PAGE;
-    
-    mgmtData->frames[frameIndex].dirty = true;
-    return RC_OK;
+    if (frameIndex >= 0) setFrameDirty(mgmtData, frameIndex);
+    unlockPool(mgmtData);
+    return (frameIndex >= 0) ? RC_OK : RC_READ_NON_EXISTING_PAGE;
 }
 
 // Force write page to disk
@@ -296,44 +1657,604 @@ RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page) {
     if (!bm || !bm->mgmtData || !page) return RC_FILE_HANDLE_NOT_INIT;
     
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
     int frameIndex = findFrame(mgmtData, page->pageNum);
-    if (frameIndex < 0) return RC_READ_NON_EXISTING_PAGE;
-    
-    return writeFrameToDisk(bm, frameIndex);
+    RC rc = RC_READ_NON_EXISTING_PAGE;
+    if (frameIndex >= 0) {
+        bool wasDirty = mgmtData->frames[frameIndex].dirty;
+        rc = writeFrameToDisk(bm, frameIndex);
+        if (rc == RC_OK) {
+            mgmtData->stats.flushes++;
+            if (wasDirty) mgmtData->stats.flushedPages++;
+        }
+    }
+    unlockPool(mgmtData);
+    return rc;
 }
 
 // Statistics functions
-PageNumber *getFrameContents(BM_BufferPool *const bm) {
-    if (!bm || !bm->mgmtData) return NULL;
+RC getFrameContentsInto(BM_BufferPool *const bm, PageNumber *contents) {
+    if (!bm || !bm->mgmtData || !contents) return RC_FILE_HANDLE_NOT_INIT;
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
-    PageNumber *contents = (PageNumber *)malloc(sizeof(PageNumber) * mgmtData->numFrames);
+    lockPool(mgmtData);
     for (int i = 0; i < mgmtData->numFrames; i++)
         contents[i] = mgmtData->frames[i].pageNum;
-    return contents;
+    unlockPool(mgmtData);
+    return RC_OK;
 }
 
-bool *getDirtyFlags(BM_BufferPool *const bm) {
-    if (!bm || !bm->mgmtData) return NULL;
+RC getDirtyFlagsInto(BM_BufferPool *const bm, bool *dirty) {
+    if (!bm || !bm->mgmtData || !dirty) return RC_FILE_HANDLE_NOT_INIT;
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
-    bool *dirty = (bool *)malloc(sizeof(bool) * mgmtData->numFrames);
+    lockPool(mgmtData);
     for (int i = 0; i < mgmtData->numFrames; i++)
         dirty[i] = mgmtData->frames[i].dirty;
-    return dirty;
+    unlockPool(mgmtData);
+    return RC_OK;
 }
 
-int *getFixCounts(BM_BufferPool *const bm) {
-    if (!bm || !bm->mgmtData) return NULL;
+RC getFixCountsInto(BM_BufferPool *const bm, int *fixCounts) {
+    if (!bm || !bm->mgmtData || !fixCounts) return RC_FILE_HANDLE_NOT_INIT;
     BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
-    int *fixCounts = (int *)malloc(sizeof(int) * mgmtData->numFrames);
+    lockPool(mgmtData);
     for (int i = 0; i < mgmtData->numFrames; i++)
         fixCounts[i] = mgmtData->frames[i].fixCount;
+    unlockPool(mgmtData);
+    return RC_OK;
+}
+
+PageNumber *getFrameContents(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return NULL;
+    PageNumber *contents = (PageNumber *)malloc(sizeof(PageNumber) * bm->numPages);
+    if (contents) getFrameContentsInto(bm, contents);
+    return contents;
+}
+
+bool *getDirtyFlags(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return NULL;
+    bool *dirty = (bool *)malloc(sizeof(bool) * bm->numPages);
+    if (dirty) getDirtyFlagsInto(bm, dirty);
+    return dirty;
+}
+
+int *getFixCounts(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return NULL;
+    int *fixCounts = (int *)malloc(sizeof(int) * bm->numPages);
+    if (fixCounts) getFixCountsInto(bm, fixCounts);
     return fixCounts;
 }
 
+RC getPoolStats(BM_BufferPool *const bm, BM_PoolStats *out) {
+    if (!bm || !bm->mgmtData || !out) return RC_FILE_HANDLE_NOT_INIT;
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    
+    lockPool(mgmtData);
+    *out = mgmtData->stats;
+    // gauges rather than counters
+    out->stickyPages = mgmtData->numSticky;
+    out->stickyLimit = mgmtData->stickyLimit;
+    unlockPool(mgmtData);
+    return RC_OK;
+}
+
+RC resetPoolStats(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    memset(&mgmtData->stats, 0, sizeof(mgmtData->stats));
+    unlockPool(mgmtData);
+    return RC_OK;
+}
+
 int getNumReadIO(BM_BufferPool *const bm) {
-    return (bm && bm->mgmtData) ? ((BM_MgmtData *)bm->mgmtData)->numReadIO : 0;
+    BM_PoolStats stats;
+    return (getPoolStats(bm, &stats) == RC_OK) ? (int)stats.readIO : 0;
 }
 
 int getNumWriteIO(BM_BufferPool *const bm) {
-    return (bm && bm->mgmtData) ? ((BM_MgmtData *)bm->mgmtData)->numWriteIO : 0;
+    BM_PoolStats stats;
+    return (getPoolStats(bm, &stats) == RC_OK) ? (int)stats.writeIO : 0;
+}
+
+// Victim cache interface
+RC setVictimCacheSize(BM_BufferPool *const bm, size_t budgetBytes) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    destroyVictimCache(mgmtData->victimCache);
+    mgmtData->victimCache = NULL;
+    if (budgetBytes == 0) return RC_OK;
+    
+    mgmtData->victimCache = createVictimCache(budgetBytes, mgmtData->pageSize);
+    return mgmtData->victimCache ? RC_OK : RC_WRITE_FAILED;
+}
+
+int getNumVictimCacheHits(BM_BufferPool *const bm) {
+    BM_PoolStats stats;
+    return (getPoolStats(bm, &stats) == RC_OK) ? (int)stats.victimCacheHits : 0;
+}
+
+int getNumVictimCacheMisses(BM_BufferPool *const bm) {
+    BM_PoolStats stats;
+    return (getPoolStats(bm, &stats) == RC_OK) ? (int)stats.victimCacheMisses : 0;
+}
+
+// L2 cache interface
+RC setL2Cache(BM_BufferPool *const bm, const char *cacheFileName, int capacityPages) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    destroyL2Cache(mgmtData->l2Cache);
+    mgmtData->l2Cache = NULL;
+    if (!cacheFileName || capacityPages <= 0) return RC_OK;
+    
+    mgmtData->l2Cache = createL2Cache(cacheFileName, capacityPages, mgmtData->pageSize);
+    return mgmtData->l2Cache ? RC_OK : RC_WRITE_FAILED;
+}
+
+RC syncL2(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    syncL2Cache(((BM_MgmtData *)bm->mgmtData)->l2Cache);
+    return RC_OK;
+}
+
+// Access trace interface
+RC startAccessTrace(BM_BufferPool *const bm, const char *traceFileName) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (!traceFileName) return RC_FILE_NOT_FOUND;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (mgmtData->accessTrace) closeAccessTraceWriter(mgmtData->accessTrace);
+    mgmtData->accessTrace = openAccessTraceWriter(traceFileName);
+    return mgmtData->accessTrace ? RC_OK : RC_WRITE_FAILED;
+}
+
+RC stopAccessTrace(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    RC rc = closeAccessTraceWriter(mgmtData->accessTrace);
+    mgmtData->accessTrace = NULL;
+    return rc;
+}
+
+int getPoolPageSize(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return 0;
+    return ((BM_MgmtData *)bm->mgmtData)->pageSize;
+}
+
+ReplacementStrategy getLiveStrategy(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return bm ? bm->strategy : RS_FIFO;
+    return ((BM_MgmtData *)bm->mgmtData)->liveStrategy;
+}
+
+// Clean-preferring eviction
+RC setEvictionWindow(BM_BufferPool *const bm, int window) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (window > mgmtData->numFrames) window = mgmtData->numFrames;
+    if (window <= 1) {
+        free(mgmtData->candidates);
+        mgmtData->candidates = NULL;
+        mgmtData->evictionWindow = 0;
+        return RC_OK;
+    }
+    
+    EvictCandidate *cand = (EvictCandidate *)realloc(mgmtData->candidates,
+                                                     sizeof(EvictCandidate) * window);
+    if (!cand) return RC_WRITE_FAILED;
+    mgmtData->candidates = cand;
+    mgmtData->evictionWindow = window;
+    return RC_OK;
+}
+
+RC setAdmissionFilter(BM_BufferPool *const bm, bool enabled) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (enabled == (mgmtData->admission != NULL)) return RC_OK;
+    Frame *transient = &mgmtData->frames[mgmtData->numFrames];
+    
+    if (enabled) {
+        mgmtData->admission = createFreqSketch(mgmtData->numFrames);
+        if (!mgmtData->admission) return RC_WRITE_FAILED;
+        for (int t = 0; t < BM_TRANSIENT_FRAMES; t++) {
+            transient[t].data = (char *)malloc(mgmtData->pageSize);
+            if (transient[t].data) continue;
+            while (t-- > 0) {
+                free(transient[t].data);
+                transient[t].data = NULL;
+            }
+            destroyFreqSketch(mgmtData->admission);
+            mgmtData->admission = NULL;
+            return RC_WRITE_FAILED;
+        }
+        return RC_OK;
+    }
+    
+    // transient pages go back to disk before their frames disappear
+    for (int t = 0; t < BM_TRANSIENT_FRAMES; t++)
+        if (transient[t].fixCount > 0) return RC_WRITE_FAILED;
+    for (int t = 0; t < BM_TRANSIENT_FRAMES; t++) {
+        RC rc = evictFrame(bm, mgmtData->numFrames + t);
+        if (rc != RC_OK) return rc;
+    }
+    for (int t = 0; t < BM_TRANSIENT_FRAMES; t++) {
+        free(transient[t].data);
+        transient[t].data = NULL;
+    }
+    destroyFreqSketch(mgmtData->admission);
+    mgmtData->admission = NULL;
+    return RC_OK;
+}
+
+RC setMissRatioTracking(BM_BufferPool *const bm, int maxSampledPages) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (maxSampledPages < 0) return RC_WRITE_FAILED;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    MR_Tracker *tracker = NULL;
+    if (maxSampledPages > 0) {
+        tracker = createMissRatioTracker(maxSampledPages);
+        if (!tracker) return RC_WRITE_FAILED;
+    }
+    lockPool(mgmtData);
+    destroyMissRatioTracker(mgmtData->missRatio);
+    mgmtData->missRatio = tracker;
+    unlockPool(mgmtData);
+    return RC_OK;
+}
+
+RC estimateMissRatio(BM_BufferPool *const bm, int numPages, double *missRatio) {
+    if (!bm || !bm->mgmtData || !missRatio) return RC_FILE_HANDLE_NOT_INIT;
+    if (numPages < 0) return RC_WRITE_FAILED;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    bool known = estimateTrackerMissRatio(mgmtData->missRatio, numPages, missRatio);
+    unlockPool(mgmtData);
+    return known ? RC_OK : RC_FILE_HANDLE_NOT_INIT;
+}
+
+RC setSampleSize(BM_BufferPool *const bm, int samples) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (samples < 0) return RC_WRITE_FAILED;
+    ((BM_MgmtData *)bm->mgmtData)->sampleSize = samples ? samples : BM_DEFAULT_SAMPLE_SIZE;
+    return RC_OK;
+}
+
+// Warm restart interface
+RC setWarmRestart(BM_BufferPool *const bm, bool enabled) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    ((BM_MgmtData *)bm->mgmtData)->warmRestart = enabled;
+    return RC_OK;
+}
+
+RC prewarm(BM_BufferPool *const bm, PageNumber firstPage, PageNumber lastPage) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    if (firstPage < 0 || lastPage < firstPage || firstPage >= mgmtData->fileHandle->totalNumPages) {
+        unlockPool(mgmtData);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    if (lastPage >= mgmtData->fileHandle->totalNumPages)
+        lastPage = mgmtData->fileHandle->totalNumPages - 1;
+    
+    // loading more pages than frames would only evict the range's own head
+    if (lastPage - firstPage + 1 > mgmtData->numFrames)
+        lastPage = firstPage + mgmtData->numFrames - 1;
+    
+    int maxRun = loadRunPages(mgmtData);
+    char *staging = (char *)malloc((size_t)maxRun * mgmtData->pageSize);
+    int *frames = (int *)malloc(sizeof(int) * maxRun);
+    RC rc = (staging && frames) ? RC_OK : RC_WRITE_FAILED;
+    
+    setAccessHint(mgmtData->fileHandle, SM_HINT_SEQUENTIAL);
+    for (PageNumber p = firstPage, run; rc == RC_OK && p <= lastPage; p += run) {
+        run = 1;
+        if (findFrame(mgmtData, p) >= 0) continue;
+        while (run < maxRun && p + run <= lastPage && findFrame(mgmtData, p + run) < 0) run++;
+        rc = loadRunUnpinned(bm, p, run, staging, frames);
+    }
+    setAccessHint(mgmtData->fileHandle, SM_HINT_NORMAL);
+    unlockPool(mgmtData);
+    
+    free(staging);
+    free(frames);
+    return rc;
+}
+
+// Helper: drop the pages of a range from the pool and its caches; the
+// caller holds the pool lock
+static RC invalidateRange(BM_BufferPool *const bm, PageNumber firstPage, PageNumber lastPage) {
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    int numSlots = mgmtData->numFrames + (mgmtData->admission ? BM_TRANSIENT_FRAMES : 0);
+    for (int i = 0; i < numSlots; i++) {
+        Frame *frame = &mgmtData->frames[i];
+        if (frame->pageNum >= firstPage && frame->pageNum <= lastPage && frame->fixCount > 0)
+            return RC_WRITE_FAILED;
+    }
+    
+    for (int i = 0; i < numSlots; i++) {
+        Frame *frame = &mgmtData->frames[i];
+        if (frame->pageNum < firstPage || frame->pageNum > lastPage) continue;
+        clearFrameDirty(mgmtData, i);
+        setFramePage(mgmtData, i, NO_PAGE);
+        releaseFrame(mgmtData, i);
+    }
+    dropVictimRange(mgmtData->victimCache, firstPage, lastPage);
+    dropL2Range(mgmtData->l2Cache, firstPage, lastPage);
+    
+    // pick up pages published through other handles, and keep pinNewPage
+    // from handing out their numbers again
+    RC rc = ensureCapacity(0, mgmtData->fileHandle);
+    if (rc != RC_OK) return rc;
+    if (mgmtData->nextNewPage < mgmtData->fileHandle->totalNumPages)
+        mgmtData->nextNewPage = mgmtData->fileHandle->totalNumPages;
+    return RC_OK;
+}
+
+RC invalidatePages(BM_BufferPool *const bm, PageNumber firstPage, PageNumber lastPage) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (firstPage < 0 || lastPage < firstPage) return RC_READ_NON_EXISTING_PAGE;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    RC rc = invalidateRange(bm, firstPage, lastPage);
+    unlockPool(mgmtData);
+    return rc;
+}
+
+RC deallocatePage(BM_BufferPool *const bm, PageNumber pageNum) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (pageNum < 0) return RC_READ_NON_EXISTING_PAGE;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    RC rc = invalidateRange(bm, pageNum, pageNum);
+    // a new page that was never flushed gets its place in the file first
+    if (rc == RC_OK && pageNum < mgmtData->nextNewPage && pageNum >= mgmtData->fileHandle->totalNumPages)
+        rc = ensureCapacity(pageNum + 1, mgmtData->fileHandle);
+    if (rc == RC_OK) rc = freePage(pageNum, mgmtData->fileHandle);
+    unlockPool(mgmtData);
+    return rc;
+}
+
+// Partition interface
+RC createPartition(BM_BufferPool *const bm, const char *name, int minFrames, int maxFrames,
+                   int *partition) {
+    if (!bm || !bm->mgmtData || !name || !partition) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (findPartition(bm, name) >= 0) return RC_WRITE_FAILED;
+    
+    int id = 1;
+    while (id < BM_MAX_PARTITIONS && mgmtData->partitions[id].used) id++;
+    if (id == BM_MAX_PARTITIONS) return RC_WRITE_FAILED;
+    
+    BM_Partition *part = &mgmtData->partitions[id];
+    memset(part, 0, sizeof(BM_Partition));
+    part->used = true;
+    RC rc = setPartitionQuota(bm, id, minFrames, maxFrames);
+    if (rc != RC_OK) {
+        part->used = false;
+        return rc;
+    }
+    strncpy(part->name, name, BM_PARTITION_NAME_LEN - 1);
+    mgmtData->numPartitions++;
+    *partition = id;
+    return RC_OK;
+}
+
+// Takes effect lazily: a partition left over its new maximum is the first to
+// lose frames on the next misses
+RC setPartitionQuota(BM_BufferPool *const bm, int partition, int minFrames, int maxFrames) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (partition < 0 || partition >= BM_MAX_PARTITIONS || !mgmtData->partitions[partition].used)
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (minFrames < 0 || maxFrames < 1 || minFrames > maxFrames || maxFrames > mgmtData->numFrames)
+        return RC_WRITE_FAILED;
+    
+    // the minimums must be satisfiable together
+    int reserved = minFrames;
+    for (int q = 0; q < BM_MAX_PARTITIONS; q++)
+        if (q != partition && mgmtData->partitions[q].used) reserved += mgmtData->partitions[q].minFrames;
+    if (reserved > mgmtData->numFrames) return RC_WRITE_FAILED;
+    
+    mgmtData->partitions[partition].minFrames = minFrames;
+    mgmtData->partitions[partition].maxFrames = maxFrames;
+    return RC_OK;
+}
+
+int findPartition(BM_BufferPool *const bm, const char *name) {
+    if (!bm || !bm->mgmtData || !name) return -1;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    for (int q = 0; q < BM_MAX_PARTITIONS; q++)
+        if (mgmtData->partitions[q].used && strcmp(mgmtData->partitions[q].name, name) == 0) return q;
+    return -1;
+}
+
+RC pinPageInPartition(BM_BufferPool *const bm, BM_PageHandle *const page,
+                      const PageNumber pageNum, int partition) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (partition < 0 || partition >= BM_MAX_PARTITIONS || !mgmtData->partitions[partition].used)
+        return RC_FILE_HANDLE_NOT_INIT;
+    return pinPageInternal(bm, page, pageNum, NULL, partition, BM_PRIORITY_NORMAL);
+}
+
+RC getPartitionStats(BM_BufferPool *const bm, int partition, BM_PartitionStats *out) {
+    if (!bm || !bm->mgmtData || !out) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (partition < 0 || partition >= BM_MAX_PARTITIONS || !mgmtData->partitions[partition].used)
+        return RC_FILE_HANDLE_NOT_INIT;
+    *out = mgmtData->partitions[partition].stats;
+    out->frames = mgmtData->partitions[partition].frames;
+    return RC_OK;
+}
+
+// Priority and residency interface
+RC pinPageWithPriority(BM_BufferPool *const bm, BM_PageHandle *const page,
+                       const PageNumber pageNum, BM_PinPriority priority) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (priority < BM_PRIORITY_LOW || priority > BM_PRIORITY_HIGH) return RC_WRITE_FAILED;
+    
+    return pinPageInternal(bm, page, pageNum, NULL, 0, priority);
+}
+
+RC setPageResidency(BM_BufferPool *const bm, PageNumber pageNum, BM_Residency residency) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    RC rc = RC_OK;
+    lockPool(mgmtData);
+    int frameIndex = findFrame(mgmtData, pageNum);
+    if (residency == BM_RESIDENCY_NORMAL) {
+        if (frameIndex >= 0 && mgmtData->frames[frameIndex].sticky) {
+            mgmtData->frames[frameIndex].sticky = false;
+            mgmtData->numSticky--;
+        }
+    } else if (frameIndex < 0 || !mgmtData->frames[frameIndex].sticky) {
+        if (mgmtData->numSticky >= mgmtData->stickyLimit) {
+            rc = RC_WRITE_FAILED;
+        } else {
+            // a pin loads the page and holds the frame while it is marked;
+            // it does not wait for a frame, the lock is held throughout
+            BM_PageHandle page;
+            rc = pinPageFrame(bm, &page, pageNum, NULL, &frameIndex);
+            if (rc == RC_OK) {
+                Frame *frame = &mgmtData->frames[frameIndex];
+                frame->sticky = true;
+                frame->ringFrame = false;
+                mgmtData->numSticky++;
+                if (--frame->fixCount == 0 && mgmtData->waitHead)
+                    pthread_cond_signal(&mgmtData->waitHead->wake);
+            }
+        }
+    }
+    unlockPool(mgmtData);
+    return rc;
+}
+
+RC setStickyFraction(BM_BufferPool *const bm, double fraction) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    if (fraction < 0 || fraction > 1) return RC_WRITE_FAILED;
+    
+    // lowering the limit keeps pages already sticky; only new ones are refused
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    mgmtData->stickyLimit = (int)(fraction * mgmtData->numFrames);
+    return RC_OK;
+}
+
+// Concurrent mode interface
+RC setConcurrentMode(BM_BufferPool *const bm, bool enabled) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (enabled == mgmtData->concurrent) return RC_OK;
+    if (enabled) {
+        if (pthread_mutex_init(&mgmtData->poolLock, NULL) != 0) return RC_WRITE_FAILED;
+    } else {
+        pthread_mutex_destroy(&mgmtData->poolLock);
+        mgmtData->pinWaitMs = 0;
+    }
+    mgmtData->concurrent = enabled;
+    return RC_OK;
+}
+
+RC setPinWaitTimeout(BM_BufferPool *const bm, int timeoutMs) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    // a single thread waiting on itself would never wake up
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    if (!mgmtData->concurrent && timeoutMs != 0) return RC_WRITE_FAILED;
+    lockPool(mgmtData);
+    mgmtData->pinWaitMs = timeoutMs;
+    unlockPool(mgmtData);
+    return RC_OK;
+}
+
+// Incremental checkpoint interface. The trickle runs only in these calls,
+// never in pinPage/unpinPage, so foreground pins do no checkpoint I/O and a
+// failed write is returned to the caller driving the checkpoint.
+RC beginCheckpoint(BM_BufferPool *const bm, int pagesPerSecond) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    mgmtData->checkpointHorizon = mgmtData->dirtyCounter;
+    mgmtData->pagesPerSecond = pagesPerSecond > 0 ? pagesPerSecond : 0;
+    mgmtData->checkpointTokens = 1;
+    mgmtData->checkpointRefillNs = nowNs();
+    mgmtData->checkpointPaused = false;
+    mgmtData->checkpointActive = true;
+    RC rc = checkpointTick(bm);
+    unlockPool(mgmtData);
+    return rc;
+}
+
+RC checkpointStep(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    RC rc = checkpointTick(bm);
+    unlockPool(mgmtData);
+    return rc;
+}
+
+RC pauseCheckpoint(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    lockPool(mgmtData);
+    mgmtData->checkpointPaused = true;
+    unlockPool(mgmtData);
+    return RC_OK;
+}
+
+RC resumeCheckpoint(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    RC rc = RC_OK;
+    lockPool(mgmtData);
+    if (mgmtData->checkpointPaused) {
+        // no credit for the time spent paused
+        mgmtData->checkpointPaused = false;
+        mgmtData->checkpointTokens = 0;
+        mgmtData->checkpointRefillNs = nowNs();
+        rc = checkpointTick(bm);
+    }
+    unlockPool(mgmtData);
+    return rc;
+}
+
+int getCheckpointPending(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return 0;
+    
+    BM_MgmtData *mgmtData = (BM_MgmtData *)bm->mgmtData;
+    int pending = 0;
+    lockPool(mgmtData);
+    if (mgmtData->checkpointActive) {
+        for (int i = mgmtData->dirtyHead;
+             i >= 0 && mgmtData->frames[i].dirtySeq <= mgmtData->checkpointHorizon;
+             i = mgmtData->frames[i].dirtyNext)
+            pending++;
+    }
+    unlockPool(mgmtData);
+    return pending;
+}
+
+int getNumDirtyPages(BM_BufferPool *const bm) {
+    if (!bm || !bm->mgmtData) return 0;
+    return ((BM_MgmtData *)bm->mgmtData)->numDirty;
 }
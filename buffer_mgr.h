@@ -7,13 +7,22 @@
 // Include bool DT
 #include "dt.h"
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Replacement Strategies
 typedef enum ReplacementStrategy {
 	RS_FIFO = 0,
 	RS_LRU = 1,
 	RS_CLOCK = 2,
 	RS_LFU = 3,
-	RS_LRU_K = 4
+	RS_LRU_K = 4,
+	RS_ADAPTIVE = 5,  // switches between the strategies above at run time
+	RS_SAMPLED_LRU = 6,  // best of a few random frames, see setSampleSize
+	RS_SAMPLED_LFU = 7
 } ReplacementStrategy;
 
 // Data Types and Structures
@@ -33,6 +42,84 @@ typedef struct BM_PageHandle {
 	char *data;
 } BM_PageHandle;
 
+// Access hints: scans and bulk writes recycle a small private ring of frames
+// instead of flushing the hot set out of the main pool
+typedef enum BM_AccessHint {
+	BM_HINT_NORMAL = 0,
+	BM_HINT_SEQUENTIAL = 1,
+	BM_HINT_BULK_WRITE = 2
+} BM_AccessHint;
+
+#define BM_SEQUENTIAL_RING_SIZE 8
+#define BM_BULK_WRITE_RING_SIZE 32
+
+typedef struct BM_AccessStrategy {
+	BM_AccessHint hint;
+	int ringSize;
+	int current;
+	int *frames; // frame index per ring slot, -1 while unused
+} BM_AccessStrategy;
+
+// Pool statistics, see getPoolStats. Latency histograms are log2 buckets:
+// bucket i counts calls that took [2^i, 2^(i+1)) nanoseconds.
+#define BM_LATENCY_BUCKETS 32
+
+typedef struct BM_PoolStats {
+	long long hits;              // pins served from a frame
+	long long misses;            // pins that had to load the page
+	long long cleanEvictions;
+	long long dirtyEvictions;    // evictions that wrote the victim first
+	long long dirtyFallbacks;    // eviction windows without a clean frame
+	long long pinFailures;
+	long long newPages;          // pages allocated by pinNewPage
+	long long flushes;           // forcePage and forceFlushPool calls
+	long long flushedPages;      // dirty pages written by those calls
+	long long checkpointPages;   // dirty pages written by incremental checkpoints
+	long long readIO;
+	long long writeIO;
+	long long victimCacheHits;
+	long long victimCacheMisses;
+	long long l2Hits;            // loads served from the L2 cache file
+	long long l2Misses;
+	long long strategySwitches;  // live strategy changes of an RS_ADAPTIVE pool
+	long long pinWaits;          // pins that queued for a frame
+	long long pinWaitTimeouts;   // of those, pins that gave up (RC_PIN_TIMEOUT)
+	long long admissionRejects;  // misses served from a transient frame
+	long long stickyPages;       // pages made sticky by setPageResidency (gauge)
+	long long stickyLimit;       // frames that may be sticky at once (gauge)
+	long long readLatency[BM_LATENCY_BUCKETS];
+	long long writeLatency[BM_LATENCY_BUCKETS];
+	long long pinWaitLatency[BM_LATENCY_BUCKETS];
+} BM_PoolStats;
+
+// Pin priorities, see pinPageWithPriority
+typedef enum BM_PinPriority {
+	BM_PRIORITY_LOW = 0,
+	BM_PRIORITY_NORMAL = 1,
+	BM_PRIORITY_HIGH = 2
+} BM_PinPriority;
+
+typedef enum BM_Residency {
+	BM_RESIDENCY_NORMAL = 0,
+	BM_RESIDENCY_STICKY = 1
+} BM_Residency;
+
+// share of the frames that may hold sticky pages, see setStickyFraction
+#define BM_DEFAULT_STICKY_FRACTION 0.25
+
+// Partitions: named frame quotas inside one pool, see createPartition
+#define BM_MAX_PARTITIONS 16
+#define BM_PARTITION_NAME_LEN 32
+
+typedef struct BM_PartitionStats {
+	long long frames;            // frames charged to the partition now
+	long long hits;              // pins through the partition
+	long long misses;
+	long long readIO;
+	long long writeIO;           // writes of pages in its frames
+	long long evictions;         // pages it lost to make room
+} BM_PartitionStats;
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -53,6 +140,18 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+// allocate a page freed by deallocatePage, or one past the end of the file,
+// and pin it zeroed and dirty; nothing is read, and the page is written
+// when it is flushed
+RC pinNewPage (BM_BufferPool *const bm, BM_PageHandle *const page,
+		PageNumber *pageNum);
+
+// Access strategies (ringSize <= 0 picks the default for the hint)
+RC initAccessStrategy (BM_BufferPool *const bm, BM_AccessStrategy *const strat,
+		BM_AccessHint hint, int ringSize);
+RC freeAccessStrategy (BM_AccessStrategy *const strat);
+RC pinPageWithStrategy (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum, BM_AccessStrategy *const strat);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -61,4 +160,133 @@ int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
 
+// Allocation-free variants: fill caller buffers of bm->numPages entries
+RC getFrameContentsInto (BM_BufferPool *const bm, PageNumber *contents);
+RC getDirtyFlagsInto (BM_BufferPool *const bm, bool *dirty);
+RC getFixCountsInto (BM_BufferPool *const bm, int *fixCounts);
+RC getPoolStats (BM_BufferPool *const bm, BM_PoolStats *out);
+RC resetPoolStats (BM_BufferPool *const bm);
+// bytes per frame, taken from the page file header
+int getPoolPageSize (BM_BufferPool *const bm);
+// strategy currently ranking victims (the chosen one unless RS_ADAPTIVE)
+ReplacementStrategy getLiveStrategy (BM_BufferPool *const bm);
+
+// Compressed victim cache: evicted pages are kept compressed within a memory
+// budget and consulted by pinPage before reading from disk (0 disables it)
+RC setVictimCacheSize (BM_BufferPool *const bm, size_t budgetBytes);
+int getNumVictimCacheHits (BM_BufferPool *const bm);
+int getNumVictimCacheMisses (BM_BufferPool *const bm);
+
+// L2 cache: clean evicted pages are copied to a local cache file (capacity in
+// pages) by a background thread and read from there before the page file.
+// Dirty pages always go to the page file, so losing the cache file is
+// harmless. A NULL file name or capacity of 0 disables it.
+RC setL2Cache (BM_BufferPool *const bm, const char *cacheFileName, int capacityPages);
+// wait until queued pages have reached the cache file
+RC syncL2 (BM_BufferPool *const bm);
+
+// Access trace: record pinPage/unpinPage/markDirty calls to a binary file
+// that replay_trace can run offline against every strategy and pool size
+RC startAccessTrace (BM_BufferPool *const bm, const char *traceFileName);
+RC stopAccessTrace (BM_BufferPool *const bm);
+
+// Clean-preferring eviction: the victim is the first clean frame among the
+// window best candidates of the strategy, or the best one if all are dirty
+// (counted as dirtyFallbacks). A window of 0 or 1 restores plain ordering.
+RC setEvictionWindow (BM_BufferPool *const bm, int window);
+
+// TinyLFU admission in front of any strategy: pins feed a frequency sketch,
+// and a miss that would evict a page at least as frequent as itself is
+// loaded into one of a few transient frames outside the pool instead (they
+// do not show in getFrameContents). Frames read by prewarm and pinNewPage
+// are always admitted. Disabling fails while a transient page is pinned.
+RC setAdmissionFilter (BM_BufferPool *const bm, bool enabled);
+
+// Sampled strategies rank this many random frames per miss (default 5) and
+// keep the best candidates between misses; more samples track exact LRU/LFU
+// more closely at a higher cost per miss. 0 restores the default.
+RC setSampleSize (BM_BufferPool *const bm, int samples);
+
+// Miss ratio curve: sample pins by page hash (SHARDS) and keep a histogram
+// of their LRU reuse distances, so estimateMissRatio can predict the LRU miss
+// ratio of any pool size from the live workload. At most maxSampledPages
+// pages are tracked (the sampling rate drops as needed to stay within it);
+// a few thousand give estimates within a point or two. 0 turns it off and
+// every call starts a new curve. estimateMissRatio fails while it is off or
+// before the first sampled pin.
+RC setMissRatioTracking (BM_BufferPool *const bm, int maxSampledPages);
+RC estimateMissRatio (BM_BufferPool *const bm, int numPages, double *missRatio);
+
+// Warm restart: when enabled, shutdownBufferPool saves the resident pages to
+// "<pageFile>.warm" and the next initBufferPool on that file reloads them
+RC setWarmRestart (BM_BufferPool *const bm, bool enabled);
+// load pages [firstPage, lastPage] without pinning them
+RC prewarm (BM_BufferPool *const bm, PageNumber firstPage, PageNumber lastPage);
+
+// drop pages [firstPage, lastPage] after they were rewritten behind the pool
+// (e.g. by a bulk load), discarding dirty copies; fails if one is pinned
+RC invalidatePages (BM_BufferPool *const bm, PageNumber firstPage, PageNumber lastPage);
+// back up the page file (see backupPageFile) after flushing the pool's dirty
+// pages, holding the pool while it copies, so the backup is consistent with
+// the pool at one point in time; incremental backups copy only changed pages
+RC backupPool (BM_BufferPool *const bm, const char *backupFileName, bool incremental);
+// free a page in the file (see freePage), dropping any copy in the pool;
+// pinNewPage hands freed pages out again before growing the file
+RC deallocatePage (BM_BufferPool *const bm, PageNumber pageNum);
+
+// Partitions: frames loaded by pinPageInPartition are charged to the
+// partition. A miss takes an empty frame while the partition is below its
+// maximum, otherwise a victim from partitions over their maximum, then from
+// those over their minimum, and only then from the partition's own pages.
+// Partition 0 ("default", no minimum, whole pool maximum) serves pinPage.
+RC createPartition (BM_BufferPool *const bm, const char *name, int minFrames, int maxFrames,
+		int *partition);
+// quotas can change at any time; excess frames are reclaimed on later misses
+RC setPartitionQuota (BM_BufferPool *const bm, int partition, int minFrames, int maxFrames);
+// partition id of a name, or -1
+int findPartition (BM_BufferPool *const bm, const char *name);
+RC pinPageInPartition (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum, int partition);
+RC getPartitionStats (BM_BufferPool *const bm, int partition, BM_PartitionStats *out);
+
+// Priorities: every strategy evicts pages of a lower priority first and uses
+// its own order among pages of equal priority. A HIGH pin keeps the page
+// ahead of normal pages until it is evicted; a LOW pin (e.g. a scan) marks it
+// as the first to go until a normal pin wants it too.
+RC pinPageWithPriority (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum, BM_PinPriority priority);
+// Sticky pages are loaded if needed and never evicted until made normal
+// again. At most fraction * numPages frames can be sticky; past that the
+// call fails with RC_WRITE_FAILED.
+RC setPageResidency (BM_BufferPool *const bm, PageNumber pageNum, BM_Residency residency);
+RC setStickyFraction (BM_BufferPool *const bm, double fraction);
+
+// Concurrent mode: pinPage (all variants), pinNewPage, unpinPage, markDirty,
+// forcePage, forceFlushPool, prewarm, invalidatePages, deallocatePage,
+// setPageResidency, the checkpoint calls, backupPool, getPoolStats,
+// resetPoolStats and the get*Into snapshots serialize on a pool lock, so
+// threads can share the pool. Configuration calls must not race with them. Enable it before the
+// pool is shared, and disable it only once no other thread uses it.
+RC setConcurrentMode (BM_BufferPool *const bm, bool enabled);
+// In concurrent mode, a pin that finds every frame pinned waits in FIFO order
+// for an unpin, failing with RC_PIN_TIMEOUT after timeoutMs (< 0 waits with
+// no limit). 0, the default, fails at once with RC_WRITE_FAILED.
+RC setPinWaitTimeout (BM_BufferPool *const bm, int timeoutMs);
+
+// Incremental checkpoint: flush the pages dirtied before beginCheckpoint,
+// oldest first, at most pagesPerSecond of them (0 = no cap). Progress is
+// made only by these calls (call checkpointStep periodically), which return
+// the error of a failed write; pinPage/unpinPage never write for it.
+RC beginCheckpoint (BM_BufferPool *const bm, int pagesPerSecond);
+RC checkpointStep (BM_BufferPool *const bm);
+RC pauseCheckpoint (BM_BufferPool *const bm);
+RC resumeCheckpoint (BM_BufferPool *const bm);
+// pages still to be written by the running checkpoint (0 when done)
+int getCheckpointPending (BM_BufferPool *const bm);
+int getNumDirtyPages (BM_BufferPool *const bm);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,144 @@
+#ifndef BUFFER_MGR_HPP
+#define BUFFER_MGR_HPP
+
+// Header-only C++ layer over the buffer manager. Pools and pinned pages are
+// plain stack objects that forward to the C calls: nothing here allocates,
+// throws or adds state beyond the C handles themselves. Errors are the C
+// return codes, available through status().
+
+#include "buffer_mgr.h"
+
+#include <cstddef>
+#include <type_traits>
+
+namespace bm {
+
+class PageGuard;
+
+// Owns an initialized BM_BufferPool and shuts it down on destruction. Guards
+// point into the pool, so it can be neither copied nor moved.
+class BufferPool {
+public:
+    BufferPool(const char *pageFile, int numPages, ReplacementStrategy strategy = RS_FIFO,
+               void *stratData = nullptr) noexcept
+        : status_(initBufferPool(&pool_, pageFile, numPages, strategy, stratData)) {}
+    ~BufferPool() {
+        if (status_ == RC_OK) shutdownBufferPool(&pool_);
+    }
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    RC status() const noexcept { return status_; }
+    explicit operator bool() const noexcept { return status_ == RC_OK; }
+    // the C handle, for calls without a wrapper here
+    BM_BufferPool *get() noexcept { return &pool_; }
+
+    inline PageGuard pin(PageNumber pageNum) noexcept;
+    inline PageGuard pinNew() noexcept;
+    RC flush() noexcept { return forceFlushPool(&pool_); }
+
+private:
+    BM_BufferPool pool_;
+    RC status_;
+};
+
+// A pinned page, unpinned when the guard is destroyed or reassigned. The
+// page handle (page number and frame data pointer) is kept inline, so a
+// guard costs two pointers, a page number and a return code on the stack.
+class PageGuard {
+public:
+    PageGuard() noexcept : pool_(nullptr), status_(RC_FILE_HANDLE_NOT_INIT) {
+        page_.pageNum = NO_PAGE;
+        page_.data = nullptr;
+    }
+    PageGuard(BM_BufferPool *pool, PageNumber pageNum) noexcept : pool_(pool) {
+        status_ = pinPage(pool, &page_, pageNum);
+        if (status_ != RC_OK) pool_ = nullptr;
+    }
+    ~PageGuard() { unpin(); }
+
+    PageGuard(const PageGuard &) = delete;
+    PageGuard &operator=(const PageGuard &) = delete;
+    PageGuard(PageGuard &&other) noexcept
+        : pool_(other.pool_), page_(other.page_), status_(other.status_) {
+        other.pool_ = nullptr;
+    }
+    PageGuard &operator=(PageGuard &&other) noexcept {
+        if (this != &other) {
+            unpin();
+            pool_ = other.pool_;
+            page_ = other.page_;
+            status_ = other.status_;
+            other.pool_ = nullptr;
+        }
+        return *this;
+    }
+
+    // pin a page past the end of the file, zeroed and dirty (pinNewPage)
+    static PageGuard pinNew(BM_BufferPool *pool) noexcept {
+        PageGuard guard;
+        PageNumber pageNum;
+        guard.status_ = pinNewPage(pool, &guard.page_, &pageNum);
+        if (guard.status_ == RC_OK) guard.pool_ = pool;
+        return guard;
+    }
+
+    // unpin early; the guard is empty afterwards
+    RC unpin() noexcept {
+        if (!pool_) return RC_OK;
+        RC rc = unpinPage(pool_, &page_);
+        pool_ = nullptr;
+        return rc;
+    }
+    RC markDirty() noexcept {
+        return pool_ ? ::markDirty(pool_, &page_) : RC_FILE_HANDLE_NOT_INIT;
+    }
+    RC force() noexcept {
+        return pool_ ? forcePage(pool_, &page_) : RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    // RC_OK if the pin succeeded, whether or not the guard was unpinned since
+    RC status() const noexcept { return status_; }
+    // whether the guard currently holds a pin
+    explicit operator bool() const noexcept { return pool_ != nullptr; }
+    PageNumber pageNum() const noexcept { return page_.pageNum; }
+    char *data() const noexcept { return page_.data; }
+
+private:
+    BM_BufferPool *pool_;       // nullptr when nothing is pinned
+    BM_PageHandle page_;
+    RC status_;
+};
+
+inline PageGuard BufferPool::pin(PageNumber pageNum) noexcept {
+    return PageGuard(&pool_, pageNum);
+}
+
+inline PageGuard BufferPool::pinNew() noexcept {
+    return PageGuard::pinNew(&pool_);
+}
+
+// Typed access to a pinned page. T is laid out directly over the frame, so it
+// must be a trivially copyable struct that fits in the smallest page; frames
+// are malloc'ed and therefore aligned for any fundamental type.
+template <typename T>
+class PageView {
+    static_assert(sizeof(T) <= PAGE_SIZE, "page struct is larger than PAGE_SIZE");
+    static_assert(std::is_trivially_copyable<T>::value, "page struct must be trivially copyable");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "page struct is over-aligned");
+
+public:
+    explicit PageView(PageGuard &guard) noexcept : guard_(guard) {}
+
+    T *get() const noexcept { return reinterpret_cast<T *>(guard_.data()); }
+    T *operator->() const noexcept { return get(); }
+    T &operator*() const noexcept { return *get(); }
+    RC markDirty() noexcept { return guard_.markDirty(); }
+
+private:
+    PageGuard &guard_;
+};
+
+} // namespace bm
+
+#endif
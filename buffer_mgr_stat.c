@@ -16,9 +16,12 @@ printPoolContent (BM_BufferPool *const bm)
 	int *fixCount;
 	int i;
 
-	frameContent = getFrameContents(bm);
-	dirty = getDirtyFlags(bm);
-	fixCount = getFixCounts(bm);
+	frameContent = (PageNumber *) malloc(sizeof(PageNumber) * bm->numPages);
+	dirty = (bool *) malloc(sizeof(bool) * bm->numPages);
+	fixCount = (int *) malloc(sizeof(int) * bm->numPages);
+	getFrameContentsInto(bm, frameContent);
+	getDirtyFlagsInto(bm, dirty);
+	getFixCountsInto(bm, fixCount);
 
 	printf("{");
 	printStrat(bm);
@@ -27,6 +30,10 @@ printPoolContent (BM_BufferPool *const bm)
 	for (i = 0; i < bm->numPages; i++)
 		printf("%s[%i%s%i]", ((i == 0) ? "" : ",") , frameContent[i], (dirty[i] ? "x": " "), fixCount[i]);
 	printf("\n");
+
+	free(frameContent);
+	free(dirty);
+	free(fixCount);
 }
 
 char *
@@ -40,13 +47,19 @@ sprintPoolContent (BM_BufferPool *const bm)
 	int pos = 0;
 
 	message = (char *) malloc(256 + (22 * bm->numPages));
-	frameContent = getFrameContents(bm);
-	dirty = getDirtyFlags(bm);
-	fixCount = getFixCounts(bm);
+	frameContent = (PageNumber *) malloc(sizeof(PageNumber) * bm->numPages);
+	dirty = (bool *) malloc(sizeof(bool) * bm->numPages);
+	fixCount = (int *) malloc(sizeof(int) * bm->numPages);
+	getFrameContentsInto(bm, frameContent);
+	getDirtyFlagsInto(bm, dirty);
+	getFixCountsInto(bm, fixCount);
 
 	for (i = 0; i < bm->numPages; i++)
 		pos += sprintf(message + pos, "%s[%i%s%i]", ((i == 0) ? "" : ",") , frameContent[i], (dirty[i] ? "x": " "), fixCount[i]);
 
+	free(frameContent);
+	free(dirty);
+	free(fixCount);
 	return message;
 }
 
@@ -98,6 +111,15 @@ printStrat (BM_BufferPool *const bm)
 	case RS_LRU_K:
 		printf("LRU-K");
 		break;
+	case RS_ADAPTIVE:
+		printf("ADAPTIVE");
+		break;
+	case RS_SAMPLED_LRU:
+		printf("SAMPLED-LRU");
+		break;
+	case RS_SAMPLED_LFU:
+		printf("SAMPLED-LFU");
+		break;
 	default:
 		printf("%i", bm->strategy);
 		break;
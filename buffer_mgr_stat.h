@@ -3,10 +3,18 @@
 
 #include "buffer_mgr.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // debug functions
 void printPoolContent (BM_BufferPool *const bm);
 void printPageContent (BM_PageHandle *const page);
 char *sprintPoolContent (BM_BufferPool *const bm);
 char *sprintPageContent (BM_PageHandle *const page);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
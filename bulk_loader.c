@@ -0,0 +1,141 @@
+#include "bulk_loader.h"
+#include "storage_mgr.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct BL_MgmtData {
+    SM_FileHandle fileHandle;
+    char *buffer;               // bufferPages pages filled by the caller
+    int bufferPages;
+    int buffered;               // slots handed out since the last write
+    PageNumber bufferStart;     // page number of slot 0
+    int reservedPages;          // the file has room for this many pages
+} BL_MgmtData;
+
+// Helper: release everything behind a load handle
+static void closeLoad(BL_BulkLoad *const bl) {
+    BL_MgmtData *mgmtData = (BL_MgmtData *)bl->mgmtData;
+    closePageFile(&mgmtData->fileHandle);
+    free(mgmtData->buffer);
+    free(mgmtData);
+    bl->mgmtData = NULL;
+}
+
+// Helper: write the filled slots with one writeBlocks call, first growing the
+// reservation geometrically when the load size was not given up front
+static RC writeBuffer(BL_BulkLoad *const bl) {
+    BL_MgmtData *mgmtData = (BL_MgmtData *)bl->mgmtData;
+    if (mgmtData->buffered == 0) return RC_OK;
+
+    int end = mgmtData->bufferStart + mgmtData->buffered;
+    if (end > mgmtData->fileHandle.totalNumPages && end > mgmtData->reservedPages) {
+        int target = end + (end - bl->firstPage);
+        if (target < end + mgmtData->bufferPages) target = end + mgmtData->bufferPages;
+        RC rc = reserveBlocks(target, &mgmtData->fileHandle);
+        if (rc != RC_OK) return rc;
+        mgmtData->reservedPages = target;
+    }
+
+    RC rc = writeBlocks(mgmtData->bufferStart, mgmtData->buffered, &mgmtData->fileHandle,
+                        mgmtData->buffer);
+    if (rc != RC_OK) return rc;
+    mgmtData->bufferStart = end;
+    mgmtData->buffered = 0;
+    return RC_OK;
+}
+
+RC beginBulkLoad(BL_BulkLoad *const bl, const char *const pageFileName,
+                 PageNumber firstPage, int bufferPages, int expectedPages) {
+    if (!bl || !pageFileName) return RC_FILE_NOT_FOUND;
+
+    BL_MgmtData *mgmtData = (BL_MgmtData *)calloc(1, sizeof(BL_MgmtData));
+    if (!mgmtData) return RC_WRITE_FAILED;
+
+    RC rc = openPageFile((char *)pageFileName, &mgmtData->fileHandle);
+    if (rc != RC_OK) {
+        free(mgmtData);
+        return rc;
+    }
+
+    bl->pageFile = (char *)pageFileName;
+    bl->pageSize = mgmtData->fileHandle.pageSize;
+    bl->firstPage = firstPage;
+    bl->numPages = 0;
+    bl->mgmtData = mgmtData;
+
+    // pages may be overwritten or appended, but not leave a gap
+    if (firstPage < 0 || firstPage > mgmtData->fileHandle.totalNumPages) {
+        closeLoad(bl);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    if (bufferPages <= 0) bufferPages = BL_DEFAULT_BUFFER_BYTES / bl->pageSize;
+    if (bufferPages <= 0) bufferPages = 1;
+    mgmtData->bufferPages = bufferPages;
+    mgmtData->bufferStart = firstPage;
+    mgmtData->buffer = (char *)malloc((size_t)bufferPages * bl->pageSize);
+    if (!mgmtData->buffer) {
+        closeLoad(bl);
+        return RC_WRITE_FAILED;
+    }
+
+    // a known size is allocated with a single extension
+    if (expectedPages > 0 && firstPage + expectedPages > mgmtData->fileHandle.totalNumPages) {
+        rc = reserveBlocks(firstPage + expectedPages, &mgmtData->fileHandle);
+        if (rc != RC_OK) {
+            closeLoad(bl);
+            return rc;
+        }
+        mgmtData->reservedPages = firstPage + expectedPages;
+    }
+    return RC_OK;
+}
+
+RC nextBulkPage(BL_BulkLoad *const bl, BM_PageHandle *const page) {
+    if (!bl || !bl->mgmtData || !page) return RC_FILE_HANDLE_NOT_INIT;
+
+    BL_MgmtData *mgmtData = (BL_MgmtData *)bl->mgmtData;
+    if (mgmtData->buffered == mgmtData->bufferPages) {
+        RC rc = writeBuffer(bl);
+        if (rc != RC_OK) return rc;
+    }
+
+    char *slot = mgmtData->buffer + (size_t)mgmtData->buffered * bl->pageSize;
+    memset(slot, 0, bl->pageSize);
+    page->pageNum = mgmtData->bufferStart + mgmtData->buffered++;
+    page->data = slot;
+    bl->numPages++;
+    return RC_OK;
+}
+
+RC finishBulkLoad(BL_BulkLoad *const bl, BM_BufferPool *const bm, BL_PoolAction action) {
+    if (!bl || !bl->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+
+    BL_MgmtData *mgmtData = (BL_MgmtData *)bl->mgmtData;
+    PageNumber end = bl->firstPage + bl->numPages;
+
+    RC rc = writeBuffer(bl);
+    // the only header write of the load, then trim what was over-reserved
+    if (rc == RC_OK && end > mgmtData->fileHandle.totalNumPages)
+        rc = ensureCapacity(end, &mgmtData->fileHandle);
+    if (rc == RC_OK) rc = reserveBlocks(0, &mgmtData->fileHandle);
+    if (rc != RC_OK) {
+        abortBulkLoad(bl);
+        return rc;
+    }
+    closeLoad(bl);
+
+    if (!bm || action == BL_POOL_NONE || bl->numPages == 0) return RC_OK;
+    rc = invalidatePages(bm, bl->firstPage, end - 1);
+    if (rc == RC_OK && action == BL_POOL_PREWARM) rc = prewarm(bm, bl->firstPage, end - 1);
+    return rc;
+}
+
+RC abortBulkLoad(BL_BulkLoad *const bl) {
+    if (!bl || !bl->mgmtData) return RC_FILE_HANDLE_NOT_INIT;
+
+    BL_MgmtData *mgmtData = (BL_MgmtData *)bl->mgmtData;
+    RC rc = reserveBlocks(0, &mgmtData->fileHandle);
+    closeLoad(bl);
+    return rc;
+}
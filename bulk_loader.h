@@ -0,0 +1,42 @@
+#ifndef BULK_LOADER_H
+#define BULK_LOADER_H
+
+#include "buffer_mgr.h"
+#include "dberror.h"
+
+// Bulk loading: pages are filled in a large caller-side buffer and streamed
+// to the page file with one sequential write per buffer, bypassing the
+// buffer pool. The file is extended in one step (or a few geometric steps
+// when the final size is unknown) and the page count is written once, when
+// the load finishes.
+#define BL_DEFAULT_BUFFER_BYTES (4 * 1024 * 1024)
+
+// what finishBulkLoad does to a pool open on the loaded file
+typedef enum BL_PoolAction {
+	BL_POOL_NONE = 0,
+	BL_POOL_INVALIDATE = 1,   // drop stale frames of the loaded pages
+	BL_POOL_PREWARM = 2       // invalidate, then load the pages unpinned
+} BL_PoolAction;
+
+typedef struct BL_BulkLoad {
+	char *pageFile;
+	int pageSize;
+	PageNumber firstPage;     // first page written by this load
+	int numPages;             // pages handed out so far
+	void *mgmtData;
+} BL_BulkLoad;
+
+// start loading pageFileName at firstPage, which may be at most the current
+// page count: existing pages from there on are overwritten and the rest are
+// appended. bufferPages <= 0 picks BL_DEFAULT_BUFFER_BYTES worth of pages;
+// expectedPages > 0 reserves the final size up front.
+RC beginBulkLoad (BL_BulkLoad *const bl, const char *const pageFileName,
+		PageNumber firstPage, int bufferPages, int expectedPages);
+// zeroed buffer slot for the next page; valid until the next call
+RC nextBulkPage (BL_BulkLoad *const bl, BM_PageHandle *const page);
+// write the rest, publish the page count and close the file; bm may be NULL
+RC finishBulkLoad (BL_BulkLoad *const bl, BM_BufferPool *const bm, BL_PoolAction action);
+// give up: appended pages are discarded, overwritten ones stay overwritten
+RC abortBulkLoad (BL_BulkLoad *const bl);
+
+#endif
@@ -3,6 +3,10 @@
 
 #include "stdio.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* module wide constants */
 #define PAGE_SIZE 4096
 
@@ -14,6 +18,9 @@ typedef int RC;
 #define RC_FILE_HANDLE_NOT_INIT 2
 #define RC_WRITE_FAILED 3
 #define RC_READ_NON_EXISTING_PAGE 4
+#define RC_INVALID_PAGE_SIZE 5
+#define RC_PIN_TIMEOUT 6
+#define RC_BACKUP_OUT_OF_ORDER 7
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
@@ -53,5 +60,8 @@ extern char *errorMessage (RC error);
 			}									\
 		} while(0);
 
+#ifdef __cplusplus
+}
+#endif
 
 #endif
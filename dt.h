@@ -1,11 +1,10 @@
 #ifndef DT_H
 #define DT_H
 
-// define bool if not defined
-#ifndef bool
-    typedef short bool;
-#define true 1
-#define false 0
+// define bool if not defined; the one-byte C99 type keeps bool arrays and
+// arguments compatible with C++ callers (see buffer_mgr.hpp)
+#if !defined(__cplusplus) && !defined(bool)
+#include <stdbool.h>
 #endif
 
 #define TRUE true
@@ -0,0 +1,151 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "event_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+__thread ET_Ring *eventRing = NULL;
+
+static ET_Ring *rings[ET_MAX_THREADS];
+static int numRings = 0;
+static int freeRings = 0;           // rings whose thread has exited
+static int nextThreadId = 0;
+static long long droppedEvents = 0;
+
+// thread-exit hook that hands the thread's ring back
+static pthread_key_t ringKey;
+static pthread_once_t ringKeyOnce = PTHREAD_ONCE_INIT;
+
+// calibration point taken when the first ring is registered
+static unsigned long long calibTicks;
+static long long calibNs;
+
+// Helper: monotonic clock in nanoseconds
+static long long clockNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+unsigned long long eventClockNs(void) {
+    return (unsigned long long)clockNs();
+}
+
+static void releaseRing(void *arg) {
+    ET_Ring *ring = (ET_Ring *)arg;
+    __sync_fetch_and_add(&freeRings, 1);
+    __atomic_store_n(&ring->active, 0, __ATOMIC_RELEASE);
+}
+
+static void createRingKey(void) {
+    pthread_key_create(&ringKey, releaseRing);
+}
+
+// Helper: take over the ring of an exited thread; its events are dropped
+static ET_Ring *recycleRing(void) {
+    if (__atomic_load_n(&freeRings, __ATOMIC_ACQUIRE) == 0) return NULL;
+    for (int i = 0; i < ET_MAX_THREADS; i++) {
+        ET_Ring *ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        int idle = 0;
+        if (ring && __atomic_compare_exchange_n(&ring->active, &idle, 1, 0, __ATOMIC_ACQ_REL,
+                                                __ATOMIC_RELAXED)) {
+            __sync_fetch_and_sub(&freeRings, 1);
+            ring->threadId = __sync_fetch_and_add(&nextThreadId, 1);
+            __atomic_store_n(&ring->head, 0, __ATOMIC_RELEASE);
+            return ring;
+        }
+    }
+    return NULL;
+}
+
+ET_Ring *registerEventRing(void) {
+    ET_Ring *ring = NULL;
+    pthread_once(&ringKeyOnce, createRingKey);
+
+    // a fresh ring while there are slots left, then exited threads' rings
+    if (__atomic_load_n(&numRings, __ATOMIC_ACQUIRE) < ET_MAX_THREADS) {
+        int slot = __sync_fetch_and_add(&numRings, 1);
+        if (slot < ET_MAX_THREADS) {
+            ring = (ET_Ring *)calloc(1, sizeof(ET_Ring));
+            if (!ring) return NULL;
+            ring->threadId = __sync_fetch_and_add(&nextThreadId, 1);
+            ring->active = 1;
+            if (slot == 0) {
+                calibTicks = eventTimestamp();
+                calibNs = clockNs();
+            }
+            __atomic_store_n(&rings[slot], ring, __ATOMIC_RELEASE);
+        }
+    }
+    if (!ring) ring = recycleRing();
+    if (!ring) {
+        __sync_fetch_and_add(&droppedEvents, 1);
+        return NULL;
+    }
+    pthread_setspecific(ringKey, ring);
+    eventRing = ring;
+    return ring;
+}
+
+long long getEventTraceDropped(void) {
+    return __atomic_load_n(&droppedEvents, __ATOMIC_ACQUIRE);
+}
+
+// Helper: clock ticks per microsecond
+static double ticksPerUs(void) {
+    if (calibNs == 0) return 1000.0;
+    long long ns = clockNs() - calibNs;
+    if (ns < 10000000) {
+        // too short an interval for a stable ratio, wait up to 10ms
+        struct timespec pause = { 0, 10000000 - ns };
+        nanosleep(&pause, NULL);
+        ns = clockNs() - calibNs;
+    }
+    return (double)(eventTimestamp() - calibTicks) * 1000.0 / ns;
+}
+
+RC dumpEventTrace(const char *fileName) {
+    int version = ET_VERSION;
+    int count = __atomic_load_n(&numRings, __ATOMIC_ACQUIRE);
+    if (count > ET_MAX_THREADS) count = ET_MAX_THREADS;
+    double rate = ticksPerUs();
+
+    FILE *fp = fopen(fileName, "wb");
+    if (!fp) THROW(RC_WRITE_FAILED, "Could not create event trace file");
+
+    fwrite(ET_MAGIC, 1, 4, fp);
+    fwrite(&version, sizeof(int), 1, fp);
+    fwrite(&rate, sizeof(double), 1, fp);
+    fwrite(&count, sizeof(int), 1, fp);
+
+    for (int i = 0; i < count; i++) {
+        ET_Ring *ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        unsigned long long head = ring ? __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) : 0;
+        unsigned long long first = (head > ET_RING_SIZE) ? head - ET_RING_SIZE : 0;
+        int n = (int)(head - first);
+        int threadId = ring ? ring->threadId : i;
+
+        fwrite(&threadId, sizeof(int), 1, fp);
+        fwrite(&n, sizeof(int), 1, fp);
+        // events of a running thread may be overwritten while we copy; the
+        // decoder tolerates that since every event is self-contained
+        for (unsigned long long e = first; e < head; e++)
+            fwrite(&ring->events[e & (ET_RING_SIZE - 1)], sizeof(ET_Event), 1, fp);
+    }
+
+    if (fclose(fp) != 0) THROW(RC_WRITE_FAILED, "Could not write event trace file");
+    return RC_OK;
+}
+
+void resetEventTrace(void) {
+    int count = __atomic_load_n(&numRings, __ATOMIC_ACQUIRE);
+    if (count > ET_MAX_THREADS) count = ET_MAX_THREADS;
+    for (int i = 0; i < count; i++) {
+        ET_Ring *ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        if (ring) __atomic_store_n(&ring->head, 0, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&droppedEvents, 0, __ATOMIC_RELEASE);
+}
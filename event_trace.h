@@ -0,0 +1,89 @@
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include "dberror.h"
+
+// Low-overhead tracepoints for the buffer and storage hot paths. Build with
+// -DBM_EVENT_TRACE (make EVENT_TRACE=1) to enable them; otherwise ET_BEGIN and
+// ET_END expand to nothing. Each thread appends to its own ring buffer, so
+// recording takes no lock; dumpEventTrace writes all rings for trace_decode.
+
+typedef enum ET_EventType {
+	ET_PIN_PAGE = 1,
+	ET_SELECT_VICTIM = 2,
+	ET_WRITE_FRAME = 3,
+	ET_READ_BLOCK = 4,
+	ET_WRITE_BLOCK = 5
+} ET_EventType;
+
+typedef struct ET_Event {
+	unsigned long long timestamp;   // clock ticks at the start of the event
+	unsigned int duration;          // ticks
+	int pageNum;
+	int frame;
+	int type;
+} ET_Event;
+
+#define ET_MAGIC "BMET"
+#define ET_VERSION 1
+#define ET_RING_SIZE 4096               // events per thread, power of two
+#define ET_MAX_THREADS 64
+
+typedef struct ET_Ring {
+	unsigned long long head;        // events ever written; only the owner advances it
+	int threadId;
+	int active;                     // owned by a live thread; 0 once it exits
+	ET_Event events[ET_RING_SIZE];
+} ET_Ring;
+
+// dump file: magic, version, ticks per microsecond (double), ring count,
+// then per ring: threadId, event count, events oldest first
+RC dumpEventTrace (const char *fileName);
+// discard recorded events; call only while no thread is recording
+void resetEventTrace (void);
+// events not recorded since the last reset. A thread's ring is recycled
+// when it exits (keeping its events until then), so this stays 0 unless
+// more than ET_MAX_THREADS threads record at the same time.
+long long getEventTraceDropped (void);
+ET_Ring *registerEventRing (void);
+
+// clock used for timestamps: the TSC on x86-64, nanoseconds elsewhere
+#if defined(__x86_64__) || defined(__i386__)
+static inline unsigned long long eventTimestamp (void) {
+	return __builtin_ia32_rdtsc();
+}
+#else
+unsigned long long eventClockNs (void);
+static inline unsigned long long eventTimestamp (void) {
+	return eventClockNs();
+}
+#endif
+
+#ifdef BM_EVENT_TRACE
+
+extern __thread ET_Ring *eventRing;
+
+static inline void recordEvent (int type, int pageNum, int frame, unsigned long long start) {
+	ET_Ring *ring = eventRing ? eventRing : registerEventRing();
+	if (!ring) return;
+	unsigned long long head = ring->head;
+	ET_Event *e = &ring->events[head & (ET_RING_SIZE - 1)];
+	e->timestamp = start;
+	e->duration = (unsigned int)(eventTimestamp() - start);
+	e->pageNum = pageNum;
+	e->frame = frame;
+	e->type = type;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+#define ET_BEGIN(var) unsigned long long var = eventTimestamp()
+#define ET_END(type, pageNum, frame, var) recordEvent((type), (pageNum), (frame), (var))
+
+#else
+
+#define ET_BEGIN(var)
+#define ET_END(type, pageNum, frame, var) ((void)0)
+
+#endif
+
+#endif
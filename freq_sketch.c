@@ -0,0 +1,88 @@
+#include "freq_sketch.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define FS_ROWS 4
+#define FS_AGING_FACTOR 10      // accesses per counter column between agings
+
+// Row r is words [r * rowWords, (r + 1) * rowWords); each 64-bit word packs
+// sixteen 4-bit counters
+struct FS_Sketch {
+    uint64_t *table;
+    unsigned int mask;          // counters per row - 1
+    int rowWords;
+    long long additions;
+    long long agingPeriod;
+};
+
+// Helper: 64-bit finalizer (splitmix64), so nearby page numbers spread out
+static uint64_t mixPage(PageNumber pageNum) {
+    uint64_t h = (uint64_t)(uint32_t)pageNum + 0x9E3779B97F4A7C15ull;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+// Helper: counter index of a page in a row, by double hashing
+static unsigned int counterIndex(FS_Sketch *fs, uint64_t h, int row) {
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+    return (h1 + (uint32_t)row * h2) & fs->mask;
+}
+
+static uint64_t *counterWord(FS_Sketch *fs, int row, unsigned int index) {
+    return &fs->table[(size_t)row * fs->rowWords + (index >> 4)];
+}
+
+FS_Sketch *createFreqSketch(int numFrames) {
+    if (numFrames <= 0) return NULL;
+    FS_Sketch *fs = (FS_Sketch *)calloc(1, sizeof(FS_Sketch));
+    if (!fs) return NULL;
+
+    unsigned int width = 64;
+    while (width < (unsigned)numFrames) width <<= 1;
+    fs->mask = width - 1;
+    fs->rowWords = width / 16;
+    fs->agingPeriod = (long long)FS_AGING_FACTOR * width;
+    fs->table = (uint64_t *)calloc((size_t)FS_ROWS * fs->rowWords, sizeof(uint64_t));
+    if (!fs->table) {
+        free(fs);
+        return NULL;
+    }
+    return fs;
+}
+
+void destroyFreqSketch(FS_Sketch *fs) {
+    if (!fs) return;
+    free(fs->table);
+    free(fs);
+}
+
+void recordPageAccess(FS_Sketch *fs, PageNumber pageNum) {
+    if (!fs) return;
+    uint64_t h = mixPage(pageNum);
+    for (int row = 0; row < FS_ROWS; row++) {
+        unsigned int index = counterIndex(fs, h, row);
+        uint64_t *word = counterWord(fs, row, index);
+        int shift = (index & 15) * 4;
+        if (((*word >> shift) & 0xF) < 0xF) *word += (uint64_t)1 << shift;
+    }
+
+    // aging: halve every counter at once, dropping the low bit of each nibble
+    if (++fs->additions >= fs->agingPeriod) {
+        for (size_t w = 0; w < (size_t)FS_ROWS * fs->rowWords; w++)
+            fs->table[w] = (fs->table[w] >> 1) & 0x7777777777777777ull;
+        fs->additions /= 2;
+    }
+}
+
+int estimatePageFrequency(FS_Sketch *fs, PageNumber pageNum) {
+    if (!fs) return 0;
+    uint64_t h = mixPage(pageNum);
+    int estimate = 0xF;
+    for (int row = 0; row < FS_ROWS; row++) {
+        unsigned int index = counterIndex(fs, h, row);
+        int count = (int)((*counterWord(fs, row, index) >> ((index & 15) * 4)) & 0xF);
+        if (count < estimate) estimate = count;
+    }
+    return estimate;
+}
@@ -0,0 +1,19 @@
+#ifndef FREQ_SKETCH_H
+#define FREQ_SKETCH_H
+
+#include "buffer_mgr.h"
+
+// Count-min sketch of page access frequencies for TinyLFU admission: four
+// rows of 4-bit saturating counters, about as many counters per row as the
+// pool has frames (2 bytes per frame in total). Every 10 * frames recorded
+// accesses all counters are halved, so old popularity fades.
+typedef struct FS_Sketch FS_Sketch;
+
+FS_Sketch *createFreqSketch (int numFrames);
+void destroyFreqSketch (FS_Sketch *fs);
+
+void recordPageAccess (FS_Sketch *fs, PageNumber pageNum);
+// estimated accesses since the last agings, 0..15
+int estimatePageFrequency (FS_Sketch *fs, PageNumber pageNum);
+
+#endif
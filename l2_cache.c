@@ -0,0 +1,249 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "l2_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+// Cache file slot i holds one page at offset i * pageSize. Slots are indexed
+// by a chained hash on the page number and replaced in CLOCK order.
+typedef struct L2_Slot {
+    PageNumber pageNum;         // NO_PAGE while free or being rewritten
+    int hashNext;               // next slot in the bucket, -1 at the end
+    bool referenced;
+} L2_Slot;
+
+struct L2_Cache {
+    int fd;
+    char *fileName;
+    int pageSize;
+    int capacity;
+    int used;                   // slots handed out so far
+    int hand;
+    int numBuckets;
+    int *buckets;
+    L2_Slot *slots;
+    // write queue: a ring of page copies, the head entry is being written
+    char *queueData;
+    PageNumber queuePages[L2_QUEUE_PAGES];  // NO_PAGE once dropped
+    int queueHead;
+    int queueCount;
+    bool headCanceled;          // the head entry was dropped while in flight
+    bool stopping;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t idle;
+};
+
+// Helper: bucket of a page number
+static int *bucketOf(L2_Cache *l2, PageNumber pageNum) {
+    return &l2->buckets[((unsigned)pageNum * 2654435761u) & (unsigned)(l2->numBuckets - 1)];
+}
+
+// Helper: slot holding a page, or -1
+static int lookupSlot(L2_Cache *l2, PageNumber pageNum) {
+    for (int s = *bucketOf(l2, pageNum); s >= 0; s = l2->slots[s].hashNext)
+        if (l2->slots[s].pageNum == pageNum) return s;
+    return -1;
+}
+
+// Helper: unlink a slot from its bucket and mark it free
+static void freeSlot(L2_Cache *l2, int slot) {
+    int *link = bucketOf(l2, l2->slots[slot].pageNum);
+    while (*link != slot) link = &l2->slots[*link].hashNext;
+    *link = l2->slots[slot].hashNext;
+    l2->slots[slot].pageNum = NO_PAGE;
+    l2->slots[slot].hashNext = -1;
+}
+
+// Helper: a slot to write into: an unused one, a free one, or the CLOCK victim
+static int claimSlot(L2_Cache *l2) {
+    if (l2->used < l2->capacity) return l2->used++;
+    for (;;) {
+        L2_Slot *slot = &l2->slots[l2->hand];
+        int s = l2->hand;
+        l2->hand = (l2->hand + 1) % l2->capacity;
+        if (slot->pageNum == NO_PAGE) return s;
+        if (slot->referenced) {
+            slot->referenced = false;
+            continue;
+        }
+        freeSlot(l2, s);
+        return s;
+    }
+}
+
+// Helper: background writer; the slot is taken out of the index before the
+// write and published after it, so readers never see a half-written page
+static void *writerLoop(void *arg) {
+    L2_Cache *l2 = (L2_Cache *)arg;
+
+    pthread_mutex_lock(&l2->lock);
+    for (;;) {
+        while (!l2->stopping && l2->queueCount == 0) pthread_cond_wait(&l2->work, &l2->lock);
+        if (l2->stopping) break;
+
+        PageNumber pageNum = l2->queuePages[l2->queueHead];
+        if (pageNum != NO_PAGE && lookupSlot(l2, pageNum) < 0) {
+            int slot = claimSlot(l2);
+            const char *data = l2->queueData + (size_t)l2->queueHead * l2->pageSize;
+            l2->headCanceled = false;
+            pthread_mutex_unlock(&l2->lock);
+            bool written = pwrite(l2->fd, data, l2->pageSize, (off_t)slot * l2->pageSize) == l2->pageSize;
+            pthread_mutex_lock(&l2->lock);
+            if (written && !l2->headCanceled) {
+                int *bucket = bucketOf(l2, pageNum);
+                l2->slots[slot].pageNum = pageNum;
+                l2->slots[slot].referenced = false;
+                l2->slots[slot].hashNext = *bucket;
+                *bucket = slot;
+            }
+        }
+        l2->queueHead = (l2->queueHead + 1) % L2_QUEUE_PAGES;
+        if (--l2->queueCount == 0) pthread_cond_broadcast(&l2->idle);
+    }
+    pthread_mutex_unlock(&l2->lock);
+    return NULL;
+}
+
+L2_Cache *createL2Cache(const char *fileName, int capacityPages, int pageSize) {
+    if (!fileName || capacityPages <= 0 || pageSize <= 0) return NULL;
+    L2_Cache *l2 = (L2_Cache *)calloc(1, sizeof(L2_Cache));
+    if (!l2) return NULL;
+
+    l2->fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    l2->fileName = (char *)malloc(strlen(fileName) + 1);
+    l2->pageSize = pageSize;
+    l2->capacity = capacityPages;
+    l2->numBuckets = 64;
+    while (l2->numBuckets < capacityPages) l2->numBuckets <<= 1;
+    l2->buckets = (int *)malloc(sizeof(int) * l2->numBuckets);
+    l2->slots = (L2_Slot *)malloc(sizeof(L2_Slot) * capacityPages);
+    l2->queueData = (char *)malloc((size_t)L2_QUEUE_PAGES * pageSize);
+    if (l2->fd < 0 || !l2->fileName || !l2->buckets || !l2->slots || !l2->queueData) {
+        if (l2->fd >= 0) {
+            close(l2->fd);
+            unlink(fileName);
+        }
+        free(l2->fileName);
+        free(l2->buckets);
+        free(l2->slots);
+        free(l2->queueData);
+        free(l2);
+        return NULL;
+    }
+    strcpy(l2->fileName, fileName);
+    for (int b = 0; b < l2->numBuckets; b++) l2->buckets[b] = -1;
+    for (int s = 0; s < capacityPages; s++) {
+        l2->slots[s].pageNum = NO_PAGE;
+        l2->slots[s].hashNext = -1;
+        l2->slots[s].referenced = false;
+    }
+
+    pthread_mutex_init(&l2->lock, NULL);
+    pthread_cond_init(&l2->work, NULL);
+    pthread_cond_init(&l2->idle, NULL);
+    if (pthread_create(&l2->writer, NULL, writerLoop, l2) != 0) {
+        l2->stopping = true;
+        destroyL2Cache(l2);
+        return NULL;
+    }
+    return l2;
+}
+
+void destroyL2Cache(L2_Cache *l2) {
+    if (!l2) return;
+    pthread_mutex_lock(&l2->lock);
+    bool running = !l2->stopping;
+    l2->stopping = true;
+    pthread_cond_signal(&l2->work);
+    pthread_mutex_unlock(&l2->lock);
+    if (running) pthread_join(l2->writer, NULL);
+
+    // without the in-memory index the file is useless
+    close(l2->fd);
+    unlink(l2->fileName);
+    pthread_mutex_destroy(&l2->lock);
+    pthread_cond_destroy(&l2->work);
+    pthread_cond_destroy(&l2->idle);
+    free(l2->fileName);
+    free(l2->buckets);
+    free(l2->slots);
+    free(l2->queueData);
+    free(l2);
+}
+
+void putL2Page(L2_Cache *l2, PageNumber pageNum, const char *data) {
+    if (!l2) return;
+    pthread_mutex_lock(&l2->lock);
+    bool queued = false;
+    for (int i = 0; i < l2->queueCount; i++)
+        if (l2->queuePages[(l2->queueHead + i) % L2_QUEUE_PAGES] == pageNum) queued = true;
+
+    // a full queue means the cache device is behind; the page is just not cached
+    if (!queued && l2->queueCount < L2_QUEUE_PAGES && lookupSlot(l2, pageNum) < 0) {
+        int tail = (l2->queueHead + l2->queueCount) % L2_QUEUE_PAGES;
+        memcpy(l2->queueData + (size_t)tail * l2->pageSize, data, l2->pageSize);
+        l2->queuePages[tail] = pageNum;
+        l2->queueCount++;
+        pthread_cond_signal(&l2->work);
+    }
+    pthread_mutex_unlock(&l2->lock);
+}
+
+bool getL2Page(L2_Cache *l2, PageNumber pageNum, char *data) {
+    if (!l2) return false;
+    pthread_mutex_lock(&l2->lock);
+    // read under the lock so the writer cannot reuse the slot meanwhile
+    int slot = lookupSlot(l2, pageNum);
+    bool hit = slot >= 0 &&
+               pread(l2->fd, data, l2->pageSize, (off_t)slot * l2->pageSize) == l2->pageSize;
+    if (hit) l2->slots[slot].referenced = true;
+    else if (slot >= 0) freeSlot(l2, slot);
+    pthread_mutex_unlock(&l2->lock);
+    return hit;
+}
+
+void dropL2Page(L2_Cache *l2, PageNumber pageNum) {
+    dropL2Range(l2, pageNum, pageNum);
+}
+
+void dropL2Range(L2_Cache *l2, PageNumber firstPage, PageNumber lastPage) {
+    if (!l2) return;
+    pthread_mutex_lock(&l2->lock);
+    if (firstPage == lastPage) {
+        int slot = lookupSlot(l2, firstPage);
+        if (slot >= 0) freeSlot(l2, slot);
+    } else {
+        for (int s = 0; s < l2->used; s++)
+            if (l2->slots[s].pageNum >= firstPage && l2->slots[s].pageNum <= lastPage) freeSlot(l2, s);
+    }
+    for (int i = 0; i < l2->queueCount; i++) {
+        int q = (l2->queueHead + i) % L2_QUEUE_PAGES;
+        if (l2->queuePages[q] >= firstPage && l2->queuePages[q] <= lastPage) {
+            if (i == 0) l2->headCanceled = true;
+            l2->queuePages[q] = NO_PAGE;
+        }
+    }
+    pthread_mutex_unlock(&l2->lock);
+}
+
+void syncL2Cache(L2_Cache *l2) {
+    if (!l2) return;
+    pthread_mutex_lock(&l2->lock);
+    while (l2->queueCount > 0 && !l2->stopping) pthread_cond_wait(&l2->idle, &l2->lock);
+    pthread_mutex_unlock(&l2->lock);
+}
+
+int getL2CacheEntries(L2_Cache *l2) {
+    if (!l2) return 0;
+    pthread_mutex_lock(&l2->lock);
+    int entries = 0;
+    for (int s = 0; s < l2->used; s++)
+        if (l2->slots[s].pageNum != NO_PAGE) entries++;
+    pthread_mutex_unlock(&l2->lock);
+    return entries;
+}
@@ -0,0 +1,33 @@
+#ifndef L2_CACHE_H
+#define L2_CACHE_H
+
+#include "buffer_mgr.h"
+
+// Second cache tier in a local file (e.g. on an SSD or tmpfs) for clean pages
+// evicted from a buffer pool whose page file is on slower storage. Pages are
+// queued by putL2Page and written to the cache file by a background thread;
+// the index lives in memory, so the file is scratch space and is removed by
+// destroyL2Cache. The tier only ever holds copies of what is on the primary
+// file, so losing it loses nothing: callers drop a page whenever they write
+// it to the primary file.
+typedef struct L2_Cache L2_Cache;
+
+// pages queued for the writer; puts beyond this are dropped
+#define L2_QUEUE_PAGES 32
+
+L2_Cache *createL2Cache (const char *fileName, int capacityPages, int pageSize);
+void destroyL2Cache (L2_Cache *l2);
+
+// queue a copy of a clean page; a no-op if the page is already cached
+void putL2Page (L2_Cache *l2, PageNumber pageNum, const char *data);
+// read a cached page into data; false on miss
+bool getL2Page (L2_Cache *l2, PageNumber pageNum, char *data);
+// forget a page, including a queued or in-flight copy
+void dropL2Page (L2_Cache *l2, PageNumber pageNum);
+void dropL2Range (L2_Cache *l2, PageNumber firstPage, PageNumber lastPage);
+// wait until every queued page is written or dropped
+void syncL2Cache (L2_Cache *l2);
+
+int getL2CacheEntries (L2_Cache *l2);
+
+#endif
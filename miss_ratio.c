@@ -0,0 +1,262 @@
+#include "miss_ratio.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MR_HASH_BITS 24
+#define MR_HASH_RANGE (1u << MR_HASH_BITS)
+// histogram: distances 0..7 exactly, then 8 sub-buckets per power of two
+#define MR_SUB_BUCKETS 8
+#define MR_BUCKETS (MR_SUB_BUCKETS + 40 * MR_SUB_BUCKETS)
+// last-access times are renumbered when they reach this many per entry
+#define MR_TIME_FACTOR 4
+
+typedef struct MR_Entry {
+    PageNumber pageNum;
+    uint32_t hash;
+    int lastTime;               // Fenwick position of its last access
+    int heapPos;                // position in the max-heap by hash
+    int next;                   // hash chain, also the free list
+} MR_Entry;
+
+struct MR_Tracker {
+    int maxSampled;
+    uint32_t threshold;         // pages whose hash is below it are sampled
+    MR_Entry *entries;
+    int freeEntry;
+    int *buckets;
+    unsigned int bucketMask;
+    int *heap;                  // entry indexes, highest hash first
+    int heapSize;
+    int *fenwick;               // 1 at the last-access time of each entry
+    int timeCap;
+    int now;
+    double histogram[MR_BUCKETS];
+    double coldMisses;
+    double accesses;
+};
+
+// Helper: 24-bit spatial hash of a page (splitmix64 finalizer)
+static uint32_t hashPage(PageNumber pageNum) {
+    uint64_t h = (uint64_t)(uint32_t)pageNum + 0x9E3779B97F4A7C15ull;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return (uint32_t)((h ^ (h >> 31)) >> (64 - MR_HASH_BITS));
+}
+
+static int *bucketOf(MR_Tracker *mr, PageNumber pageNum) {
+    return &mr->buckets[((unsigned)pageNum * 2654435761u) & mr->bucketMask];
+}
+
+static void fenwickAdd(MR_Tracker *mr, int pos, int delta) {
+    for (; pos <= mr->timeCap; pos += pos & -pos) mr->fenwick[pos] += delta;
+}
+
+static int fenwickSum(MR_Tracker *mr, int pos) {
+    int sum = 0;
+    for (; pos > 0; pos -= pos & -pos) sum += mr->fenwick[pos];
+    return sum;
+}
+
+// Helper: histogram bucket of a reuse distance, and the range it covers
+static int distanceBucket(double distance) {
+    if (distance >= (double)(1ull << 40)) return MR_BUCKETS - 1;
+    uint64_t d = (uint64_t)distance;
+    if (d < MR_SUB_BUCKETS) return (int)d;
+    int p = 63 - __builtin_clzll(d);
+    return MR_SUB_BUCKETS + (p - 3) * MR_SUB_BUCKETS + (int)((d >> (p - 3)) & (MR_SUB_BUCKETS - 1));
+}
+
+static void bucketRange(int bucket, double *lo, double *hi) {
+    if (bucket < MR_SUB_BUCKETS) {
+        *lo = bucket;
+        *hi = bucket + 1;
+        return;
+    }
+    int p = (bucket - MR_SUB_BUCKETS) / MR_SUB_BUCKETS + 3;
+    int sub = (bucket - MR_SUB_BUCKETS) % MR_SUB_BUCKETS;
+    double width = (double)(1ull << (p - 3));
+    *lo = (double)(1ull << p) + sub * width;
+    *hi = *lo + width;
+}
+
+// Helper: max-heap on hash
+static void heapSwap(MR_Tracker *mr, int a, int b) {
+    int ea = mr->heap[a], eb = mr->heap[b];
+    mr->heap[a] = eb;
+    mr->heap[b] = ea;
+    mr->entries[eb].heapPos = a;
+    mr->entries[ea].heapPos = b;
+}
+
+static void heapUp(MR_Tracker *mr, int pos) {
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (mr->entries[mr->heap[parent]].hash >= mr->entries[mr->heap[pos]].hash) break;
+        heapSwap(mr, pos, parent);
+        pos = parent;
+    }
+}
+
+static void heapDown(MR_Tracker *mr, int pos) {
+    for (;;) {
+        int largest = pos, l = 2 * pos + 1, r = l + 1;
+        if (l < mr->heapSize && mr->entries[mr->heap[l]].hash > mr->entries[mr->heap[largest]].hash) largest = l;
+        if (r < mr->heapSize && mr->entries[mr->heap[r]].hash > mr->entries[mr->heap[largest]].hash) largest = r;
+        if (largest == pos) return;
+        heapSwap(mr, pos, largest);
+        pos = largest;
+    }
+}
+
+// Helper: stop tracking the entry with the highest hash
+static void dropTopEntry(MR_Tracker *mr) {
+    int e = mr->heap[0];
+    MR_Entry *entry = &mr->entries[e];
+    fenwickAdd(mr, entry->lastTime, -1);
+
+    int *link = bucketOf(mr, entry->pageNum);
+    while (*link != e) link = &mr->entries[*link].next;
+    *link = entry->next;
+    entry->next = mr->freeEntry;
+    mr->freeEntry = e;
+
+    heapSwap(mr, 0, --mr->heapSize);
+    heapDown(mr, 0);
+}
+
+// Helper: renumber last-access times 1..n in order once the clock is full
+typedef struct MR_TimeOrder {
+    int lastTime;
+    int entry;
+} MR_TimeOrder;
+
+static int compareTimes(const void *a, const void *b) {
+    int ta = ((const MR_TimeOrder *)a)->lastTime, tb = ((const MR_TimeOrder *)b)->lastTime;
+    return (ta > tb) - (ta < tb);
+}
+
+static void compactTimes(MR_Tracker *mr) {
+    int n = mr->heapSize;
+    MR_TimeOrder *order = (MR_TimeOrder *)malloc(sizeof(MR_TimeOrder) * (n > 0 ? n : 1));
+    if (!order) return;
+    for (int i = 0; i < n; i++) {
+        order[i].lastTime = mr->entries[mr->heap[i]].lastTime;
+        order[i].entry = mr->heap[i];
+    }
+    qsort(order, n, sizeof(MR_TimeOrder), compareTimes);
+
+    memset(mr->fenwick, 0, sizeof(int) * (mr->timeCap + 1));
+    for (int i = 0; i < n; i++) {
+        mr->entries[order[i].entry].lastTime = i + 1;
+        fenwickAdd(mr, i + 1, 1);
+    }
+    mr->now = n + 1;
+    free(order);
+}
+
+MR_Tracker *createMissRatioTracker(int maxSampled) {
+    if (maxSampled <= 0) return NULL;
+    MR_Tracker *mr = (MR_Tracker *)calloc(1, sizeof(MR_Tracker));
+    if (!mr) return NULL;
+
+    mr->maxSampled = maxSampled;
+    mr->threshold = MR_HASH_RANGE;
+    mr->timeCap = MR_TIME_FACTOR * (maxSampled + 1);
+    unsigned int numBuckets = 64;
+    while (numBuckets < (unsigned)maxSampled * 2) numBuckets <<= 1;
+    mr->bucketMask = numBuckets - 1;
+    // one spare entry: a new page is inserted before the highest hash is dropped
+    mr->entries = (MR_Entry *)malloc(sizeof(MR_Entry) * (maxSampled + 1));
+    mr->buckets = (int *)malloc(sizeof(int) * numBuckets);
+    mr->heap = (int *)malloc(sizeof(int) * (maxSampled + 1));
+    mr->fenwick = (int *)calloc(mr->timeCap + 1, sizeof(int));
+    if (!mr->entries || !mr->buckets || !mr->heap || !mr->fenwick) {
+        destroyMissRatioTracker(mr);
+        return NULL;
+    }
+    for (unsigned int b = 0; b < numBuckets; b++) mr->buckets[b] = -1;
+    for (int e = 0; e <= maxSampled; e++) mr->entries[e].next = e < maxSampled ? e + 1 : -1;
+    mr->freeEntry = 0;
+    mr->now = 1;
+    return mr;
+}
+
+void destroyMissRatioTracker(MR_Tracker *mr) {
+    if (!mr) return;
+    free(mr->entries);
+    free(mr->buckets);
+    free(mr->heap);
+    free(mr->fenwick);
+    free(mr);
+}
+
+void recordMissRatioAccess(MR_Tracker *mr, PageNumber pageNum) {
+    if (!mr) return;
+    uint32_t hash = hashPage(pageNum);
+    if (hash >= mr->threshold) return;
+
+    if (mr->now > mr->timeCap) compactTimes(mr);
+    int e = *bucketOf(mr, pageNum);
+    while (e >= 0 && mr->entries[e].pageNum != pageNum) e = mr->entries[e].next;
+
+    mr->accesses += 1;
+    if (e >= 0) {
+        // distinct sampled pages touched since the last access, scaled up
+        MR_Entry *entry = &mr->entries[e];
+        int distinct = fenwickSum(mr, mr->now - 1) - fenwickSum(mr, entry->lastTime);
+        double rate = (double)mr->threshold / MR_HASH_RANGE;
+        mr->histogram[distanceBucket(distinct / rate)] += 1;
+        fenwickAdd(mr, entry->lastTime, -1);
+        entry->lastTime = mr->now;
+        fenwickAdd(mr, mr->now++, 1);
+        return;
+    }
+
+    mr->coldMisses += 1;
+    e = mr->freeEntry;
+    MR_Entry *entry = &mr->entries[e];
+    mr->freeEntry = entry->next;
+    int *bucket = bucketOf(mr, pageNum);
+    entry->pageNum = pageNum;
+    entry->hash = hash;
+    entry->lastTime = mr->now;
+    entry->next = *bucket;
+    *bucket = e;
+    fenwickAdd(mr, mr->now++, 1);
+    entry->heapPos = mr->heapSize;
+    mr->heap[mr->heapSize++] = e;
+    heapUp(mr, entry->heapPos);
+
+    if (mr->heapSize <= mr->maxSampled) return;
+    // over budget: lower the rate to exclude the highest hash (and any ties),
+    // then scale what was counted at the old rate down to the new one
+    uint32_t oldThreshold = mr->threshold;
+    mr->threshold = mr->entries[mr->heap[0]].hash;
+    while (mr->heapSize > 0 && mr->entries[mr->heap[0]].hash >= mr->threshold) dropTopEntry(mr);
+    double scale = (double)mr->threshold / oldThreshold;
+    for (int b = 0; b < MR_BUCKETS; b++) mr->histogram[b] *= scale;
+    mr->coldMisses *= scale;
+    mr->accesses *= scale;
+}
+
+bool estimateTrackerMissRatio(MR_Tracker *mr, int numPages, double *missRatio) {
+    if (!mr || mr->accesses <= 0) return false;
+    // a reuse at distance d hits in an LRU pool of more than d pages; within a
+    // bucket distances are taken as spread evenly
+    double misses = mr->coldMisses;
+    for (int b = 0; b < MR_BUCKETS; b++) {
+        if (mr->histogram[b] == 0) continue;
+        double lo, hi;
+        bucketRange(b, &lo, &hi);
+        if (lo >= numPages) misses += mr->histogram[b];
+        else if (hi > numPages) misses += mr->histogram[b] * (hi - numPages) / (hi - lo);
+    }
+    *missRatio = misses / mr->accesses;
+    if (*missRatio > 1) *missRatio = 1;
+    return true;
+}
+
+double getTrackerSampleRate(MR_Tracker *mr) {
+    return mr ? (double)mr->threshold / MR_HASH_RANGE : 0;
+}
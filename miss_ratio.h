@@ -0,0 +1,23 @@
+#ifndef MISS_RATIO_H
+#define MISS_RATIO_H
+
+#include "buffer_mgr.h"
+
+// Online LRU miss ratio curve (SHARDS): page numbers are hashed and only
+// those below a threshold are tracked. Their reuse distances, counted with a
+// Fenwick tree over last-access times and scaled by the sampling rate, go
+// into a log-linear histogram. At most maxSampled pages are tracked; when
+// more show up the threshold drops to evict the highest hash, and the
+// histogram is rescaled to the new rate.
+typedef struct MR_Tracker MR_Tracker;
+
+MR_Tracker *createMissRatioTracker (int maxSampled);
+void destroyMissRatioTracker (MR_Tracker *mr);
+
+void recordMissRatioAccess (MR_Tracker *mr, PageNumber pageNum);
+// estimated LRU miss ratio with numPages frames; false before any sample
+bool estimateTrackerMissRatio (MR_Tracker *mr, int numPages, double *missRatio);
+// fraction of page numbers currently sampled
+double getTrackerSampleRate (MR_Tracker *mr);
+
+#endif
@@ -0,0 +1,285 @@
+/************************************************************
+ * Access trace replay tool
+ *
+ * Replays a trace recorded with startAccessTrace against every
+ * replacement strategy and a range of pool sizes, and computes
+ * Belady's OPT miss count for each size as the theoretical floor.
+ *
+ * usage: replay_trace [-f csv|json] [-s size,size,...] traceFile
+ ************************************************************/
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "access_trace.h"
+#include "dberror.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define REPLAY_FILE "replay_pagefile.bin"
+#define MAX_POOL_SIZES 16
+
+typedef struct StrategyInfo {
+    ReplacementStrategy strategy;
+    const char *name;
+} StrategyInfo;
+
+static const StrategyInfo strategies[] = {
+    { RS_FIFO, "FIFO" },
+    { RS_LRU, "LRU" },
+    { RS_CLOCK, "CLOCK" },
+    { RS_LFU, "LFU" },
+    { RS_LRU_K, "LRU-K" },
+    { RS_ADAPTIVE, "ADAPTIVE" },
+    { RS_SAMPLED_LRU, "SAMPLED-LRU" },
+    { RS_SAMPLED_LFU, "SAMPLED-LFU" }
+};
+#define NUM_STRATEGIES ((int)(sizeof(strategies) / sizeof(strategies[0])))
+
+typedef struct Trace {
+    AT_Record *records;
+    int numRecords;
+    int numPins;
+    int numPages;               // highest page number + 1
+    int distinctPages;
+} Trace;
+
+typedef struct ReplayResult {
+    int misses;
+    int writeIO;
+    int pinFailures;
+} ReplayResult;
+
+/************************************************************
+ * TRACE LOADING
+ ************************************************************/
+
+static bool loadTrace(const char *fileName, Trace *trace) {
+    AT_Record rec;
+    int capacity = 1024;
+    FILE *fp = openAccessTraceReader(fileName);
+    if (!fp) return false;
+
+    memset(trace, 0, sizeof(Trace));
+    trace->records = (AT_Record *)malloc(sizeof(AT_Record) * capacity);
+    while (trace->records && readAccessRecord(fp, &rec)) {
+        if (rec.pageNum < 0) continue;
+        if (trace->numRecords == capacity) {
+            capacity *= 2;
+            trace->records = (AT_Record *)realloc(trace->records, sizeof(AT_Record) * capacity);
+            if (!trace->records) break;
+        }
+        trace->records[trace->numRecords++] = rec;
+        if (rec.op == AT_PIN) trace->numPins++;
+        if (rec.pageNum >= trace->numPages) trace->numPages = rec.pageNum + 1;
+    }
+    fclose(fp);
+    if (!trace->records) return false;
+
+    char *seen = (char *)calloc(trace->numPages + 1, 1);
+    for (int i = 0; i < trace->numRecords; i++)
+        if (trace->records[i].op == AT_PIN && !seen[trace->records[i].pageNum]) {
+            seen[trace->records[i].pageNum] = 1;
+            trace->distinctPages++;
+        }
+    free(seen);
+    return true;
+}
+
+/************************************************************
+ * BELADY'S OPT
+ ************************************************************/
+
+typedef struct HeapEntry {
+    int nextUse;
+    PageNumber pageNum;
+} HeapEntry;
+
+static void heapPush(HeapEntry *heap, int *size, HeapEntry e) {
+    int i = (*size)++;
+    while (i > 0 && heap[(i - 1) / 2].nextUse < e.nextUse) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = e;
+}
+
+static HeapEntry heapPop(HeapEntry *heap, int *size) {
+    HeapEntry top = heap[0], last = heap[--(*size)];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= *size) break;
+        if (child + 1 < *size && heap[child + 1].nextUse > heap[child].nextUse) child++;
+        if (heap[child].nextUse <= last.nextUse) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+/* Miss count of the optimal offline policy: evict the page reused furthest in the future */
+static int computeOptMisses(const Trace *trace, int poolSize) {
+    int numPins = trace->numPins, misses = 0, resident = 0, heapSize = 0;
+    PageNumber *pins = (PageNumber *)malloc(sizeof(PageNumber) * numPins);
+    int *nextUse = (int *)malloc(sizeof(int) * numPins);
+    int *lastSeen = (int *)malloc(sizeof(int) * trace->numPages);
+    int *curKey = (int *)malloc(sizeof(int) * trace->numPages);
+    char *inCache = (char *)calloc(trace->numPages, 1);
+    // lazy deletion: every hit pushes a fresh entry, stale ones are skipped
+    HeapEntry *heap = (HeapEntry *)malloc(sizeof(HeapEntry) * (numPins + 1));
+
+    for (int i = 0, j = 0; i < trace->numRecords; i++)
+        if (trace->records[i].op == AT_PIN) pins[j++] = trace->records[i].pageNum;
+    for (int p = 0; p < trace->numPages; p++) lastSeen[p] = INT_MAX;
+    for (int i = numPins - 1; i >= 0; i--) {
+        nextUse[i] = lastSeen[pins[i]];
+        lastSeen[pins[i]] = i;
+    }
+
+    for (int i = 0; i < numPins; i++) {
+        PageNumber p = pins[i];
+        if (!inCache[p]) {
+            misses++;
+            if (resident == poolSize) {
+                for (;;) {
+                    HeapEntry victim = heapPop(heap, &heapSize);
+                    if (inCache[victim.pageNum] && curKey[victim.pageNum] == victim.nextUse) {
+                        inCache[victim.pageNum] = 0;
+                        resident--;
+                        break;
+                    }
+                }
+            }
+            inCache[p] = 1;
+            resident++;
+        }
+        curKey[p] = nextUse[i];
+        HeapEntry e = { nextUse[i], p };
+        heapPush(heap, &heapSize, e);
+    }
+
+    free(pins);
+    free(nextUse);
+    free(lastSeen);
+    free(curKey);
+    free(inCache);
+    free(heap);
+    return misses;
+}
+
+/************************************************************
+ * REPLAY
+ ************************************************************/
+
+static RC replay(const Trace *trace, ReplacementStrategy strategy, int poolSize,
+                 ReplayResult *result) {
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    RC rc = initBufferPool(&bm, REPLAY_FILE, poolSize, strategy, NULL);
+    if (rc != RC_OK) return rc;
+
+    result->pinFailures = 0;
+    for (int i = 0; i < trace->numRecords; i++) {
+        const AT_Record *rec = &trace->records[i];
+        h.pageNum = rec->pageNum;
+        switch (rec->op) {
+            case AT_PIN:
+                if (pinPage(&bm, &h, rec->pageNum) != RC_OK) result->pinFailures++;
+                break;
+            case AT_UNPIN: unpinPage(&bm, &h); break;
+            case AT_MARK_DIRTY: markDirty(&bm, &h); break;
+        }
+    }
+    result->misses = getNumReadIO(&bm);
+    result->writeIO = getNumWriteIO(&bm);
+    return shutdownBufferPool(&bm);
+}
+
+static void printRow(bool json, bool first, const char *strategy, int poolSize,
+                     const Trace *trace, const ReplayResult *r) {
+    double hitRatio = trace->numPins ? 1.0 - (double)r->misses / trace->numPins : 0;
+    if (json)
+        printf("%s  {\"strategy\": \"%s\", \"pool_pages\": %d, \"pins\": %d, \"misses\": %d, "
+               "\"hit_ratio\": %.4f, \"write_io\": %d, \"pin_failures\": %d}",
+               first ? "" : ",\n", strategy, poolSize, trace->numPins, r->misses, hitRatio,
+               r->writeIO, r->pinFailures);
+    else
+        printf("%s,%d,%d,%d,%.4f,%d,%d\n", strategy, poolSize, trace->numPins, r->misses,
+               hitRatio, r->writeIO, r->pinFailures);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-f csv|json] [-s size,size,...] traceFile\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    Trace trace;
+    ReplayResult result;
+    int poolSizes[MAX_POOL_SIZES], numPoolSizes = 0;
+    const char *traceFile = NULL;
+    bool json = false, first = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            json = strcmp(argv[++i], "json") == 0;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            for (char *tok = strtok(argv[++i], ","); tok && numPoolSizes < MAX_POOL_SIZES;
+                 tok = strtok(NULL, ","))
+                if (atoi(tok) > 0) poolSizes[numPoolSizes++] = atoi(tok);
+        } else if (argv[i][0] != '-' && !traceFile) {
+            traceFile = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!traceFile) usage(argv[0]);
+
+    if (!loadTrace(traceFile, &trace)) {
+        fprintf(stderr, "%s: not a readable access trace\n", traceFile);
+        return 1;
+    }
+    if (trace.numPins == 0) {
+        fprintf(stderr, "%s: trace contains no pins\n", traceFile);
+        return 1;
+    }
+
+    // default sizes: 1%, 5%, 10%, 25% and 50% of the distinct pages
+    if (numPoolSizes == 0) {
+        const int percents[] = { 1, 5, 10, 25, 50 };
+        for (int i = 0; i < 5; i++) {
+            int size = trace.distinctPages * percents[i] / 100;
+            if (size < 1) size = 1;
+            if (numPoolSizes == 0 || size != poolSizes[numPoolSizes - 1])
+                poolSizes[numPoolSizes++] = size;
+        }
+    }
+
+    initStorageManager();
+    SM_FileHandle fh;
+    CHECK(createPageFile(REPLAY_FILE));
+    CHECK(openPageFile(REPLAY_FILE, &fh));
+    CHECK(ensureCapacity(trace.numPages, &fh));
+    CHECK(closePageFile(&fh));
+
+    if (json) printf("[\n");
+    else printf("strategy,pool_pages,pins,misses,hit_ratio,write_io,pin_failures\n");
+
+    for (int p = 0; p < numPoolSizes; p++) {
+        ReplayResult opt = { computeOptMisses(&trace, poolSizes[p]), 0, 0 };
+        printRow(json, first, "OPT", poolSizes[p], &trace, &opt);
+        first = false;
+        for (int s = 0; s < NUM_STRATEGIES; s++) {
+            CHECK(replay(&trace, strategies[s].strategy, poolSizes[p], &result));
+            printRow(json, first, strategies[s].name, poolSizes[p], &trace, &result);
+        }
+    }
+    if (json) printf("\n]\n");
+
+    free(trace.records);
+    CHECK(destroyPageFile(REPLAY_FILE));
+    return 0;
+}
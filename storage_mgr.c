@@ -3,12 +3,584 @@
  * CS525 - Advanced Database Organization
  * Storage Manager Implementation - Assignment 1
  ************************************************************/
+#define _GNU_SOURCE              /* fallocate hole punching, SEEK_HOLE */
+#define _POSIX_C_SOURCE 200809L
+
 #include "storage_mgr.h"
 #include "dberror.h"
+#include "event_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+/* File headers. A legacy file starts with the page count alone and holds
+ * PAGE_SIZE pages. A sized file starts with a header block of magic, version,
+ * page count and page size; the magic is negative so it can never be read as
+ * a legacy page count, and the block keeps pages filesystem-block aligned. */
+#define LEGACY_HEADER_SIZE ((int)sizeof(int))
+#define SM_HEADER_SIZE 4096
+#define SM_HEADER_MAGIC ((int)0xDB5E0001)
+#define SM_HEADER_VERSION 1
+
+/* Free-space map. Freed pages are kept in a bitmap in a "<pageFile>.free"
+ * sidecar (magic, then bit i for page i) so neither header format changes and
+ * older readers still open the file; the sidecar is created by the first
+ * freePage. A freed page is punched out of the file and reads as zeros. */
+#define SM_FREE_MAGIC ((int)0xDB5EF1EE)
+
+/* Changed-page map for incremental backups, in a "<pageFile>.changed"
+ * sidecar (magic, epoch, then bit i for page i). Tracking starts with the
+ * first backup of a file; until then every backup is a full one. */
+#define SM_CHANGED_MAGIC ((int)0xDB5EC4A6)
+#define SM_CHANGED_HEADER (2 * (int)sizeof(int))
+
+/* Backup files: a header, then runs of pages (start, count, zero flag and,
+ * unless the run reads as zeros, its pages), ended by a run of 0 pages */
+#define SM_BACKUP_MAGIC ((int)0xDB5EBAC0)
+#define SM_BACKUP_VERSION 1
+#define SM_BACKUP_RUN_PAGES 64
+
+/* A file rebuilt by restoreBackup records the epoch of the last backup
+ * applied in a "<pageFile>.restored" sidecar (magic, epoch); an incremental
+ * only applies on top of the epoch it was taken from */
+#define SM_RESTORED_MAGIC ((int)0xDB5E4E57)
+
+typedef struct SM_BackupHeader {
+    int magic;
+    int version;
+    int pageSize;
+    int headerSize;             /* of the source file: legacy or sized layout */
+    int totalNumPages;
+    int baseEpoch;              /* 0 for a full backup */
+    int epoch;                  /* the file's epoch once this backup is taken */
+    int numPages;               /* pages in the runs */
+} SM_BackupHeader;
+
+typedef struct SM_BackupRun {
+    int start;
+    int count;
+    int zero;
+} SM_BackupRun;
+
+/* Header offset of the page count */
+static long pageCountOffset(int headerSize) {
+    return (headerSize == LEGACY_HEADER_SIZE) ? 0 : 2 * sizeof(int);
+}
+
+/* File offset of a page */
+static long pageOffset(SM_FileHandle *fHandle, int pageNum) {
+    return fHandle->headerSize + (long)pageNum * fHandle->pageSize;
+}
+
+static int validPageSize(int pageSize) {
+    return pageSize >= SM_MIN_PAGE_SIZE && pageSize <= SM_MAX_PAGE_SIZE &&
+           (pageSize & (pageSize - 1)) == 0;
+}
+
+/************************************************************
+ * FILE HANDLE CACHE
+ ************************************************************/
+
+/* Open page files are shared through a cache keyed by path. An entry owns
+ * one descriptor plus the header fields read when it was opened, and counts
+ * the handles using it. Entries without handles stay open on an LRU list and
+ * are closed only when the cache needs room, so reopening a recent file
+ * costs neither an open() nor a header read. Page I/O uses pread/pwrite, so
+ * handles on the same file can share the descriptor. */
+#define FILE_CACHE_BUCKETS 1024
+#define FILE_CACHE_MIN_LIMIT 16
+
+typedef struct SM_FileInfo {
+    char *path;
+    int fd;
+    int refCount;
+    int detached;               /* destroyed or recreated while in use */
+    int totalNumPages;
+    int reservedPages;          /* allocated past the count by reserveBlocks */
+    int pageSize;
+    int headerSize;
+    int blockSize;              /* filesystem block, for widening punched holes */
+    /* page maps, guarded by mapLock: freed pages, and pages known to read as
+     * zeros (freed, or holes never written) which readBlock serves from memory */
+    pthread_mutex_t mapLock;
+    unsigned char *freeBits;
+    unsigned char *zeroBits;
+    int mapPages;               /* pages the bitmaps have room for */
+    int numFree;
+    int numZero;                /* read without the lock to skip it when 0 */
+    int freeHint;               /* no free page below this byte of freeBits */
+    int freeFd;                 /* the sidecar, -1 until it exists */
+    /* pages written since the last backup; pendingBits holds the pages of a
+     * backup in progress, which stay in the sidecar until it completes */
+    int tracking;               /* read without the lock to skip it when 0 */
+    unsigned char *changedBits;
+    unsigned char *pendingBits;
+    int pendingPages;
+    int numChanged;
+    int epoch;
+    int changedFd;
+    struct SM_FileInfo *hashNext;
+    struct SM_FileInfo *idlePrev;   /* LRU list of entries without handles */
+    struct SM_FileInfo *idleNext;
+} SM_FileInfo;
+
+static pthread_mutex_t cacheLock = PTHREAD_MUTEX_INITIALIZER;
+static SM_FileInfo *buckets[FILE_CACHE_BUCKETS];
+static SM_FileInfo *idleHead, *idleTail;    /* head is least recently used */
+static int numOpenFiles, maxOpenFiles;
+static int cacheHits, cacheMisses;
+
+/* FNV-1a hash of a path */
+static unsigned int hashPath(const char *path) {
+    unsigned int h = 2166136261u;
+    while (*path) {
+        h ^= (unsigned char)*path++;
+        h *= 16777619u;
+    }
+    return h % FILE_CACHE_BUCKETS;
+}
+
+/* At most half of the soft descriptor limit is kept by the cache */
+static int fileCacheLimit(void) {
+    struct rlimit rl;
+    
+    if (maxOpenFiles == 0) {
+        maxOpenFiles = 1024;
+        if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY &&
+            rl.rlim_cur / 2 < (rlim_t)maxOpenFiles) {
+            maxOpenFiles = (int)(rl.rlim_cur / 2);
+        }
+        if (maxOpenFiles < FILE_CACHE_MIN_LIMIT) {
+            maxOpenFiles = FILE_CACHE_MIN_LIMIT;
+        }
+    }
+    return maxOpenFiles;
+}
+
+static SM_FileInfo *lookupFile(const char *path) {
+    SM_FileInfo *info = buckets[hashPath(path)];
+    while (info != NULL && strcmp(info->path, path) != 0) {
+        info = info->hashNext;
+    }
+    return info;
+}
+
+static void unhashFile(SM_FileInfo *info) {
+    SM_FileInfo **link = &buckets[hashPath(info->path)];
+    while (*link != NULL && *link != info) {
+        link = &(*link)->hashNext;
+    }
+    if (*link != NULL) {
+        *link = info->hashNext;
+    }
+}
+
+static void idleUnlink(SM_FileInfo *info) {
+    if (info->idlePrev) info->idlePrev->idleNext = info->idleNext;
+    else idleHead = info->idleNext;
+    if (info->idleNext) info->idleNext->idlePrev = info->idlePrev;
+    else idleTail = info->idlePrev;
+    info->idlePrev = info->idleNext = NULL;
+}
+
+static void idleAppend(SM_FileInfo *info) {
+    info->idleNext = NULL;
+    info->idlePrev = idleTail;
+    if (idleTail) idleTail->idleNext = info;
+    else idleHead = info;
+    idleTail = info;
+}
+
+static void closeFileInfo(SM_FileInfo *info) {
+    close(info->fd);
+    if (info->freeFd >= 0) close(info->freeFd);
+    if (info->changedFd >= 0) close(info->changedFd);
+    pthread_mutex_destroy(&info->mapLock);
+    free(info->freeBits);
+    free(info->zeroBits);
+    free(info->changedBits);
+    free(info->pendingBits);
+    free(info->path);
+    free(info);
+    numOpenFiles--;
+}
+
+/* Close least recently used idle files until the cache is below its limit */
+static void makeRoom(int limit) {
+    while (numOpenFiles >= limit && idleHead != NULL) {
+        SM_FileInfo *victim = idleHead;
+        idleUnlink(victim);
+        unhashFile(victim);
+        closeFileInfo(victim);
+    }
+}
+
+/* Drop the cache entry of a file that is about to be recreated or removed;
+ * handles still using it keep the old descriptor until they close */
+static void invalidateCachedFile(const char *path) {
+    pthread_mutex_lock(&cacheLock);
+    SM_FileInfo *info = lookupFile(path);
+    if (info != NULL) {
+        unhashFile(info);
+        if (info->refCount == 0) {
+            idleUnlink(info);
+            closeFileInfo(info);
+        } else {
+            info->detached = 1;
+        }
+    }
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/************************************************************
+ * PAGE MAPS
+ ************************************************************/
+
+static int testBit(const unsigned char *bits, int page) {
+    return (bits[page >> 3] >> (page & 7)) & 1;
+}
+
+/* Make room for page in every bitmap; called with mapLock held */
+static int growMaps(SM_FileInfo *info, int page) {
+    if (page < info->mapPages) return 1;
+    
+    int pages = info->mapPages > 0 ? info->mapPages : 1024;
+    while (pages <= page) pages *= 2;
+    size_t oldBytes = (size_t)info->mapPages / 8, bytes = (size_t)pages / 8;
+    unsigned char *freeBits = (unsigned char *)realloc(info->freeBits, bytes);
+    if (freeBits == NULL) return 0;
+    info->freeBits = freeBits;
+    unsigned char *zeroBits = (unsigned char *)realloc(info->zeroBits, bytes);
+    if (zeroBits == NULL) return 0;
+    info->zeroBits = zeroBits;
+    unsigned char *changedBits = (unsigned char *)realloc(info->changedBits, bytes);
+    if (changedBits == NULL) return 0;
+    info->changedBits = changedBits;
+    memset(freeBits + oldBytes, 0, bytes - oldBytes);
+    memset(zeroBits + oldBytes, 0, bytes - oldBytes);
+    memset(changedBits + oldBytes, 0, bytes - oldBytes);
+    info->mapPages = pages;
+    return 1;
+}
+
+/* Record pages [start, end) as reading zeros; called with mapLock held */
+static void markZeroPages(SM_FileInfo *info, int start, int end) {
+    if (end <= start || !growMaps(info, end - 1)) return;
+    for (int p = start; p < end; p++) {
+        if (!testBit(info->zeroBits, p)) {
+            info->zeroBits[p >> 3] |= 1 << (p & 7);
+            __atomic_add_fetch(&info->numZero, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/* Write the sidecar byte holding page's free bit */
+static void persistFreeBit(SM_FileInfo *info, int page) {
+    if (info->freeFd >= 0) {
+        pwrite(info->freeFd, &info->freeBits[page >> 3], 1, sizeof(int) + (page >> 3));
+    }
+}
+
+/* Write the changed-map bytes covering pages [start, end); pages of a backup
+ * in progress stay set until it completes */
+static void persistChangedBits(SM_FileInfo *info, int start, int end) {
+    for (int byte = start >> 3; byte <= (end - 1) >> 3; byte++) {
+        unsigned char bits = info->changedBits[byte];
+        if (info->pendingBits != NULL && byte < (info->pendingPages + 7) / 8) {
+            bits |= info->pendingBits[byte];
+        }
+        pwrite(info->changedFd, &bits, 1, SM_CHANGED_HEADER + byte);
+    }
+}
+
+/* Record pages [start, end) as changed since the last backup; the sidecar
+ * is written only when a page changes for the first time in the epoch.
+ * Called with mapLock held. */
+static void markChanged(SM_FileInfo *info, int start, int end) {
+    int first = -1, last = -1;
+    
+    if (!info->tracking || end <= start || !growMaps(info, end - 1)) return;
+    for (int p = start; p < end; p++) {
+        if (testBit(info->changedBits, p)) continue;
+        info->changedBits[p >> 3] |= 1 << (p & 7);
+        info->numChanged++;
+        if (first < 0) first = p;
+        last = p;
+    }
+    if (first >= 0) persistChangedBits(info, first, last + 1);
+}
+
+/* Whether pages [start, start + count) all read as zeros */
+static int pagesAreZero(SM_FileInfo *info, int start, int count) {
+    int zero = 1;
+    
+    if (__atomic_load_n(&info->numZero, __ATOMIC_RELAXED) == 0) return 0;
+    pthread_mutex_lock(&info->mapLock);
+    for (int p = start; p < start + count && zero; p++) {
+        zero = p < info->mapPages && testBit(info->zeroBits, p);
+    }
+    pthread_mutex_unlock(&info->mapLock);
+    return zero;
+}
+
+/* Pages about to be written are marked changed and stop reading as zeros;
+ * writing a freed page allocates it again */
+static void claimPages(SM_FileInfo *info, int start, int count) {
+    if (__atomic_load_n(&info->numZero, __ATOMIC_RELAXED) == 0 &&
+        !__atomic_load_n(&info->tracking, __ATOMIC_RELAXED)) return;
+    pthread_mutex_lock(&info->mapLock);
+    markChanged(info, start, start + count);
+    for (int p = start; p < start + count && p < info->mapPages; p++) {
+        if (!testBit(info->zeroBits, p)) continue;
+        info->zeroBits[p >> 3] &= ~(1 << (p & 7));
+        __atomic_sub_fetch(&info->numZero, 1, __ATOMIC_RELAXED);
+        if (testBit(info->freeBits, p)) {
+            info->freeBits[p >> 3] &= ~(1 << (p & 7));
+            info->numFree--;
+            persistFreeBit(info, p);
+        }
+    }
+    pthread_mutex_unlock(&info->mapLock);
+}
+
+/* Sidecar path of a page file ("<fileName><suffix>"); the caller frees it */
+static char *sidecarPath(const char *fileName, const char *suffix) {
+    char *path = (char *)malloc(strlen(fileName) + strlen(suffix) + 1);
+    if (path != NULL) sprintf(path, "%s%s", fileName, suffix);
+    return path;
+}
+
+static void removeSidecars(const char *fileName) {
+    const char *suffixes[] = { ".free", ".changed", ".restored" };
+    for (int i = 0; i < 3; i++) {
+        char *path = sidecarPath(fileName, suffixes[i]);
+        if (path != NULL) unlink(path);
+        free(path);
+    }
+}
+
+/* Load the changed-page map of a file that has been backed up */
+static void loadChangedMap(SM_FileInfo *info) {
+    char *path = sidecarPath(info->path, ".changed");
+    int header[2];
+    struct stat st;
+    
+    info->changedFd = path != NULL ? open(path, O_RDWR) : -1;
+    free(path);
+    if (info->changedFd < 0) return;
+    if (pread(info->changedFd, header, sizeof(header), 0) != sizeof(header) ||
+        header[0] != SM_CHANGED_MAGIC || fstat(info->changedFd, &st) != 0) {
+        close(info->changedFd);
+        info->changedFd = -1;
+        return;
+    }
+    info->tracking = 1;
+    info->epoch = header[1];
+    
+    int bytes = (int)(st.st_size - SM_CHANGED_HEADER);
+    if (bytes > 0 && growMaps(info, bytes * 8 - 1)) {
+        if (pread(info->changedFd, info->changedBits, bytes, SM_CHANGED_HEADER) != bytes) {
+            memset(info->changedBits, 0, bytes);
+        }
+        for (int p = 0; p < bytes * 8; p++) {
+            info->numChanged += testBit(info->changedBits, p);
+        }
+    }
+}
+
+/* Load the free map of a page file being opened, and mark pages that lie in
+ * holes of the file; both read as zeros without I/O */
+static void loadPageMaps(SM_FileInfo *info) {
+    char *path = sidecarPath(info->path, ".free");
+    int magic;
+    
+    loadChangedMap(info);
+    info->freeFd = path != NULL ? open(path, O_RDWR) : -1;
+    free(path);
+    if (info->freeFd >= 0 &&
+        (pread(info->freeFd, &magic, sizeof(int), 0) != sizeof(int) || magic != SM_FREE_MAGIC)) {
+        close(info->freeFd);
+        info->freeFd = -1;
+    }
+    if (info->freeFd >= 0 && info->totalNumPages > 0 && growMaps(info, info->totalNumPages - 1)) {
+        ssize_t n = pread(info->freeFd, info->freeBits, (info->totalNumPages + 7) / 8, sizeof(int));
+        for (int p = 0; n > 0 && p < info->totalNumPages && p < n * 8; p++) {
+            if (testBit(info->freeBits, p)) {
+                info->numFree++;
+                markZeroPages(info, p, p + 1);
+            } 
+        }
+        /* bits past the page count are stale */
+        for (int p = info->totalNumPages; p < info->mapPages; p++) {
+            info->freeBits[p >> 3] &= ~(1 << (p & 7));
+        }
+    }
+    
+#ifdef SEEK_HOLE
+    off_t end = info->headerSize + (off_t)info->totalNumPages * info->pageSize;
+    off_t hole = lseek(info->fd, info->headerSize, SEEK_HOLE);
+    while (hole >= 0 && hole < end) {
+        off_t data = lseek(info->fd, hole, SEEK_DATA);
+        if (data < 0 || data > end) data = end;
+        int first = (int)((hole - info->headerSize + info->pageSize - 1) / info->pageSize);
+        int last = (int)((data - info->headerSize) / info->pageSize);
+        markZeroPages(info, first, last);
+        if (data >= end) break;
+        hole = lseek(info->fd, data, SEEK_HOLE);
+    }
+#endif
+}
+
+/* Open a page file and read its header into a new cache entry */
+static RC openFileInfo(char *fileName, SM_FileInfo **out) {
+    SM_FileInfo *info;
+    struct stat st;
+    int fd, totalPages, header[3];
+    int pageSize = PAGE_SIZE, headerSize = LEGACY_HEADER_SIZE;
+    
+    fd = open(fileName, O_RDWR);
+    if (fd < 0) {
+        THROW(RC_FILE_NOT_FOUND, "Page file not found");
+    }
+    
+    // Read metadata: total number of pages, or the sized-file magic
+    if (pread(fd, &totalPages, sizeof(int), 0) != sizeof(int)) {
+        close(fd);
+        THROW(RC_READ_NON_EXISTING_PAGE, "Could not read metadata");
+    }
+    
+    if (totalPages < 0) {
+        if (totalPages != SM_HEADER_MAGIC ||
+            pread(fd, header, sizeof(header), sizeof(int)) != sizeof(header) ||
+            header[0] != SM_HEADER_VERSION || header[1] < 0) {
+            close(fd);
+            THROW(RC_READ_NON_EXISTING_PAGE, "Not a page file");
+        }
+        if (!validPageSize(header[2])) {
+            close(fd);
+            THROW(RC_INVALID_PAGE_SIZE, "Page file has an invalid page size");
+        }
+        totalPages = header[1];
+        pageSize = header[2];
+        headerSize = SM_HEADER_SIZE;
+    }
+    
+    // Validate metadata and verify file size
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        THROW(RC_READ_NON_EXISTING_PAGE, "Could not stat page file");
+    }
+    
+    // Recalculate if file size doesn't match (handles corrupted metadata)
+    off_t expectedSize = headerSize + (off_t)totalPages * pageSize;
+    if (st.st_size < expectedSize) {
+        close(fd);
+        THROW(RC_READ_NON_EXISTING_PAGE, "File size is smaller than expected");
+    }
+    if (st.st_size > expectedSize) {
+        // Recalculate from actual file size
+        totalPages = (int)((st.st_size - headerSize) / pageSize);
+        // Update metadata
+        if (pwrite(fd, &totalPages, sizeof(int), pageCountOffset(headerSize)) != sizeof(int)) {
+            close(fd);
+            THROW(RC_WRITE_FAILED, "Could not update metadata");
+        }
+    }
+    
+    info = (SM_FileInfo *)calloc(1, sizeof(SM_FileInfo));
+    if (info != NULL) {
+        info->path = (char *)malloc(strlen(fileName) + 1);
+    }
+    if (info == NULL || info->path == NULL) {
+        free(info);
+        close(fd);
+        THROW(RC_FILE_HANDLE_NOT_INIT, "Memory allocation failed");
+    }
+    strcpy(info->path, fileName);
+    info->fd = fd;
+    info->totalNumPages = totalPages;
+    info->pageSize = pageSize;
+    info->headerSize = headerSize;
+    info->blockSize = st.st_blksize > 0 ? (int)st.st_blksize : SM_MIN_PAGE_SIZE;
+    pthread_mutex_init(&info->mapLock, NULL);
+    loadPageMaps(info);
+    
+    *out = info;
+    return RC_OK;
+}
+
+/* Grow the file to numberOfPages pages in one step and record the count */
+static RC extendFile(SM_FileHandle *fHandle, int numberOfPages) {
+    SM_FileInfo *info = (SM_FileInfo *)fHandle->mgmtInfo;
+    
+    // extensions through different handles of one file are serialized
+    pthread_mutex_lock(&cacheLock);
+    if (info->totalNumPages < numberOfPages) {
+        // pages past the reservation are a hole; reserved ones may hold data
+        int holeStart = info->totalNumPages > info->reservedPages ? info->totalNumPages : info->reservedPages;
+        
+        // reserved pages are already allocated, only the count changes
+        if (numberOfPages > info->reservedPages &&
+            ftruncate(info->fd, pageOffset(fHandle, numberOfPages)) != 0) {
+            pthread_mutex_unlock(&cacheLock);
+            THROW(RC_WRITE_FAILED, "Could not extend file");
+        }
+        if (pwrite(info->fd, &numberOfPages, sizeof(int), pageCountOffset(info->headerSize)) != sizeof(int)) {
+            pthread_mutex_unlock(&cacheLock);
+            THROW(RC_WRITE_FAILED, "Could not update metadata");
+        }
+        info->totalNumPages = numberOfPages;
+        if (info->reservedPages <= numberOfPages) {
+            info->reservedPages = 0;
+        }
+        pthread_mutex_lock(&info->mapLock);
+        markZeroPages(info, holeStart, numberOfPages);
+        pthread_mutex_unlock(&info->mapLock);
+    }
+    fHandle->totalNumPages = info->totalNumPages;
+    pthread_mutex_unlock(&cacheLock);
+    
+    return RC_OK;
+}
+
+/* Move count pages between the file and buf, resuming short transfers */
+static int transferPages(SM_FileHandle *fHandle, int startPage, int count, char *buf, int write) {
+    SM_FileInfo *info = (SM_FileInfo *)fHandle->mgmtInfo;
+    size_t total = (size_t)count * fHandle->pageSize, done = 0;
+    off_t offset = pageOffset(fHandle, startPage);
+    
+    while (done < total) {
+        ssize_t n = write ? pwrite(info->fd, buf + done, total - done, offset + done)
+                          : pread(info->fd, buf + done, total - done, offset + done);
+        if (n <= 0) {
+            return 0;
+        }
+        done += n;
+    }
+    return 1;
+}
+
+/* Close every cached file that no handle is using */
+void closeIdleFiles(void) {
+    pthread_mutex_lock(&cacheLock);
+    makeRoom(0);
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/* Descriptors held by the cache and its lookup counters */
+void getFileCacheStats(int *openFiles, int *hits, int *misses) {
+    pthread_mutex_lock(&cacheLock);
+    if (openFiles) *openFiles = numOpenFiles;
+    if (hits) *hits = cacheHits;
+    if (misses) *misses = cacheMisses;
+    pthread_mutex_unlock(&cacheLock);
+}
 
 /************************************************************
  * INITIALIZATION
@@ -34,6 +606,10 @@ RC createPageFile(char *fileName) {
         THROW(RC_FILE_NOT_FOUND, "File name is NULL");
     }
     
+    // A cached descriptor would still describe the old file
+    invalidateCachedFile(fileName);
+    removeSidecars(fileName);
+    
     // Open file in write-binary mode
     fp = fopen(fileName, "wb");
     if (fp == NULL) {
@@ -70,85 +646,117 @@ RC createPageFile(char *fileName) {
     return RC_OK;
 }
 
-/* Open an existing page file */
-RC openPageFile(char *fileName, SM_FileHandle *fHandle) {
+/* Create a new page file of pageSize pages with one page filled with '\0' bytes */
+RC createPageFileWithSize(char *fileName, int pageSize) {
     FILE *fp;
-    long fileSize;
-    int totalPages;
+    char *block;
+    int header[4] = { SM_HEADER_MAGIC, SM_HEADER_VERSION, 1, pageSize };
     
     if (fileName == NULL) {
         THROW(RC_FILE_NOT_FOUND, "File name is NULL");
     }
     
-    if (fHandle == NULL) {
-        THROW(RC_FILE_HANDLE_NOT_INIT, "File handle is NULL");
+    if (!validPageSize(pageSize)) {
+        THROW(RC_INVALID_PAGE_SIZE, "Page size must be a power of two between 4 KB and 1 MB");
     }
     
-    // Try to open the file in read-binary+ mode
-    fp = fopen(fileName, "rb+");
+    invalidateCachedFile(fileName);
+    removeSidecars(fileName);
+    
+    fp = fopen(fileName, "wb");
     if (fp == NULL) {
-        THROW(RC_FILE_NOT_FOUND, "Page file not found");
+        THROW(RC_WRITE_FAILED, "Could not create page file");
     }
     
-    // Read metadata: total number of pages
-    if (fread(&totalPages, sizeof(int), 1, fp) != 1) {
+    // Header block followed by one empty page
+    block = (char *)calloc(SM_HEADER_SIZE + pageSize, sizeof(char));
+    if (block == NULL) {
         fclose(fp);
-        THROW(RC_READ_NON_EXISTING_PAGE, "Could not read metadata");
+        remove(fileName);
+        THROW(RC_WRITE_FAILED, "Memory allocation failed");
     }
+    memcpy(block, header, sizeof(header));
     
-    // Validate metadata and verify file size
-    fseek(fp, 0, SEEK_END);
-    fileSize = ftell(fp);
+    size_t written = fwrite(block, sizeof(char), SM_HEADER_SIZE + pageSize, fp);
     
-    // Recalculate if file size doesn't match (handles corrupted metadata)
-    long expectedSize = sizeof(int) + (long)totalPages * PAGE_SIZE;
-    if (fileSize < expectedSize) {
-        fclose(fp);
-        THROW(RC_READ_NON_EXISTING_PAGE, "File size is smaller than expected");
+    free(block);
+    fclose(fp);
+    
+    if (written < (size_t)(SM_HEADER_SIZE + pageSize)) {
+        remove(fileName);
+        THROW(RC_WRITE_FAILED, "Could not write initial page");
     }
-    if (fileSize > expectedSize) {
-        // Recalculate from actual file size
-        totalPages = (int)((fileSize - sizeof(int)) / PAGE_SIZE);
-        // Update metadata
-        fseek(fp, 0, SEEK_SET);
-        fwrite(&totalPages, sizeof(int), 1, fp);
+    
+    return RC_OK;
+}
+
+/* Open an existing page file, sharing the cached descriptor if there is one */
+RC openPageFile(char *fileName, SM_FileHandle *fHandle) {
+    SM_FileInfo *info;
+    
+    if (fileName == NULL) {
+        THROW(RC_FILE_NOT_FOUND, "File name is NULL");
     }
     
-    // Allocate and copy file name
-    fHandle->fileName = (char *)malloc(strlen(fileName) + 1);
-    if (fHandle->fileName == NULL) {
-        fclose(fp);
-        THROW(RC_FILE_HANDLE_NOT_INIT, "Memory allocation failed");
+    if (fHandle == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "File handle is NULL");
     }
-    strcpy(fHandle->fileName, fileName);
     
-    // Initialize file handle
-    fHandle->totalNumPages = totalPages;
+    pthread_mutex_lock(&cacheLock);
+    info = lookupFile(fileName);
+    if (info != NULL) {
+        cacheHits++;
+        if (info->refCount == 0) {
+            idleUnlink(info);
+        }
+    } else {
+        cacheMisses++;
+        makeRoom(fileCacheLimit());
+        RC rc = openFileInfo(fileName, &info);
+        if (rc != RC_OK) {
+            pthread_mutex_unlock(&cacheLock);
+            return rc;
+        }
+        unsigned int bucket = hashPath(fileName);
+        info->hashNext = buckets[bucket];
+        buckets[bucket] = info;
+        numOpenFiles++;
+    }
+    info->refCount++;
+    
+    // Initialize file handle; the name is owned by the cache entry
+    fHandle->fileName = info->path;
+    fHandle->totalNumPages = info->totalNumPages;
     fHandle->curPagePos = 0;
-    fHandle->mgmtInfo = fp;  // Store FILE pointer for later use
+    fHandle->mgmtInfo = info;
+    fHandle->pageSize = info->pageSize;
+    fHandle->headerSize = info->headerSize;
+    fHandle->accessHint = SM_HINT_NORMAL;
+    pthread_mutex_unlock(&cacheLock);
     
     return RC_OK;
 }
 
-/* Close an open page file */
+/* Close an open page file; the descriptor stays cached until room is needed */
 RC closePageFile(SM_FileHandle *fHandle) {
     if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
         THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
     }
     
-    FILE *fp = (FILE *)fHandle->mgmtInfo;
-    
-    fflush(fp);
-    if (fclose(fp) != 0) {
-        THROW(RC_WRITE_FAILED, "Could not close file");
-    }
+    SM_FileInfo *info = (SM_FileInfo *)fHandle->mgmtInfo;
     
-    // Free allocated memory
-    if (fHandle->fileName != NULL) {
-        free(fHandle->fileName);
-        fHandle->fileName = NULL;
+    pthread_mutex_lock(&cacheLock);
+    if (--info->refCount == 0) {
+        if (info->detached) {
+            closeFileInfo(info);
+        } else {
+            idleAppend(info);
+            makeRoom(fileCacheLimit() + 1);
+        }
     }
+    pthread_mutex_unlock(&cacheLock);
     
+    fHandle->fileName = NULL;
     fHandle->mgmtInfo = NULL;
     fHandle->totalNumPages = 0;
     fHandle->curPagePos = 0;
@@ -162,6 +770,9 @@ RC destroyPageFile(char *fileName) {
         THROW(RC_FILE_NOT_FOUND, "File name is NULL");
     }
     
+    invalidateCachedFile(fileName);
+    removeSidecars(fileName);
+    
     if (remove(fileName) != 0) {
         THROW(RC_FILE_NOT_FOUND, "Could not destroy page file");
     }
@@ -175,8 +786,8 @@ RC destroyPageFile(char *fileName) {
 
 /* Read a specific block from disk */
 RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
-    FILE *fp;
-    size_t bytesRead;
+    SM_FileInfo *info;
+    ssize_t bytesRead;
     
     // Validate file handle
     if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
@@ -188,25 +799,32 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
         THROW(RC_READ_NON_EXISTING_PAGE, "Memory page buffer is NULL");
     }
     
+    info = (SM_FileInfo *)fHandle->mgmtInfo;
+    
+    // Another handle on the file may have extended it
+    if (pageNum >= fHandle->totalNumPages) {
+        fHandle->totalNumPages = info->totalNumPages;
+    }
+    
     // Check if page number is valid
     if (pageNum < 0 || pageNum >= fHandle->totalNumPages) {
         THROW(RC_READ_NON_EXISTING_PAGE, "Page number out of bounds");
     }
     
-    fp = (FILE *)fHandle->mgmtInfo;
+    ET_BEGIN(traceStart);
     
-    // Seek to the page position (account for metadata at the beginning)
-    long offset = sizeof(int) + (long)pageNum * PAGE_SIZE;
-    if (fseek(fp, offset, SEEK_SET) != 0) {
-        THROW(RC_READ_NON_EXISTING_PAGE, "Could not seek to page");
+    // Read the page into memory (account for metadata at the beginning)
+    if (pagesAreZero(info, pageNum, 1)) {
+        memset(memPage, 0, fHandle->pageSize);
+        bytesRead = fHandle->pageSize;
+    } else {
+        bytesRead = pread(info->fd, memPage, fHandle->pageSize, pageOffset(fHandle, pageNum));
     }
     
-    // Read the page into memory
-    bytesRead = fread(memPage, sizeof(char), PAGE_SIZE, fp);
-    
-    if (bytesRead < PAGE_SIZE) {
+    if (bytesRead < fHandle->pageSize) {
         THROW(RC_READ_NON_EXISTING_PAGE, "Could not read complete page");
     }
+    ET_END(ET_READ_BLOCK, pageNum, -1, traceStart);
     
     // Update current page position
     fHandle->curPagePos = pageNum;
@@ -281,14 +899,52 @@ RC readLastBlock(SM_FileHandle *fHandle, SM_PageHandle memPage) {
     return readBlock(lastPage, fHandle, memPage);
 }
 
+/* Read count consecutive blocks into memPages with a single I/O */
+RC readBlocks(int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages) {
+    SM_FileInfo *info;
+    
+    // Validate file handle
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
+    }
+    
+    // Validate memory page buffer
+    if (memPages == NULL) {
+        THROW(RC_READ_NON_EXISTING_PAGE, "Memory page buffer is NULL");
+    }
+    
+    info = (SM_FileInfo *)fHandle->mgmtInfo;
+    if (startPage + count > fHandle->totalNumPages) {
+        fHandle->totalNumPages = info->totalNumPages;
+    }
+    
+    // Check if the page range is valid
+    if (startPage < 0 || count <= 0 || startPage + count > fHandle->totalNumPages) {
+        THROW(RC_READ_NON_EXISTING_PAGE, "Page range out of bounds");
+    }
+    
+    ET_BEGIN(traceStart);
+    if (pagesAreZero(info, startPage, count)) {
+        memset(memPages, 0, (size_t)count * fHandle->pageSize);
+    } else if (!transferPages(fHandle, startPage, count, memPages, 0)) {
+        THROW(RC_READ_NON_EXISTING_PAGE, "Could not read complete pages");
+    }
+    ET_END(ET_READ_BLOCK, startPage, -1, traceStart);
+    
+    // Update current page position
+    fHandle->curPagePos = startPage + count - 1;
+    
+    return RC_OK;
+}
+
 /************************************************************
  * WRITING BLOCKS TO DISK
  ************************************************************/
 
 /* Write a block at a specific position */
 RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
-    FILE *fp;
-    size_t bytesWritten;
+    SM_FileInfo *info;
+    ssize_t bytesWritten;
     
     // Validate file handle
     if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
@@ -300,28 +956,28 @@ RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
         THROW(RC_WRITE_FAILED, "Memory page buffer is NULL");
     }
     
+    info = (SM_FileInfo *)fHandle->mgmtInfo;
+    
+    // Another handle on the file may have extended it
+    if (pageNum >= fHandle->totalNumPages) {
+        fHandle->totalNumPages = info->totalNumPages;
+    }
+    
     // Check if page number is valid
     if (pageNum < 0 || pageNum >= fHandle->totalNumPages) {
         THROW(RC_WRITE_FAILED, "Page number out of bounds");
     }
     
-    fp = (FILE *)fHandle->mgmtInfo;
+    ET_BEGIN(traceStart);
     
-    // Seek to the page position (account for metadata at the beginning)
-    long offset = sizeof(int) + (long)pageNum * PAGE_SIZE;
-    if (fseek(fp, offset, SEEK_SET) != 0) {
-        THROW(RC_WRITE_FAILED, "Could not seek to page");
-    }
-    
-    // Write the page to disk
-    bytesWritten = fwrite(memPage, sizeof(char), PAGE_SIZE, fp);
+    // Write the page to disk (account for metadata at the beginning)
+    claimPages(info, pageNum, 1);
+    bytesWritten = pwrite(info->fd, memPage, fHandle->pageSize, pageOffset(fHandle, pageNum));
     
-    if (bytesWritten < PAGE_SIZE) {
+    if (bytesWritten < fHandle->pageSize) {
         THROW(RC_WRITE_FAILED, "Could not write complete page");
     }
-    
-    // Flush to ensure data is written
-    fflush(fp);
+    ET_END(ET_WRITE_BLOCK, pageNum, -1, traceStart);
     
     // Update current page position
     fHandle->curPagePos = pageNum;
@@ -338,78 +994,567 @@ RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage) {
     return writeBlock(fHandle->curPagePos, fHandle, memPage);
 }
 
+/* Write count consecutive blocks from memPages with a single I/O */
+RC writeBlocks(int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages) {
+    SM_FileInfo *info;
+    
+    // Validate file handle
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
+    }
+    
+    // Validate memory page buffer
+    if (memPages == NULL) {
+        THROW(RC_WRITE_FAILED, "Memory page buffer is NULL");
+    }
+    
+    info = (SM_FileInfo *)fHandle->mgmtInfo;
+    if (startPage + count > fHandle->totalNumPages) {
+        fHandle->totalNumPages = info->totalNumPages;
+    }
+    
+    // Check if the page range is valid; reserved pages may be written too
+    if (startPage < 0 || count <= 0 ||
+        (startPage + count > fHandle->totalNumPages && startPage + count > info->reservedPages)) {
+        THROW(RC_WRITE_FAILED, "Page range out of bounds");
+    }
+    
+    ET_BEGIN(traceStart);
+    claimPages(info, startPage, count);
+    if (!transferPages(fHandle, startPage, count, memPages, 1)) {
+        THROW(RC_WRITE_FAILED, "Could not write complete pages");
+    }
+    ET_END(ET_WRITE_BLOCK, startPage, -1, traceStart);
+    
+    // Update current page position
+    fHandle->curPagePos = startPage + count - 1;
+    
+    return RC_OK;
+}
+
 /* Append an empty block to the file */
 RC appendEmptyBlock(SM_FileHandle *fHandle) {
-    FILE *fp;
-    char *emptyPage;
-    size_t bytesWritten;
-    int newTotalPages;
-    long currentPos;
-    
     // Validate file handle
     if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
         THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
     }
     
-    fp = (FILE *)fHandle->mgmtInfo;
+    return extendFile(fHandle, fHandle->totalNumPages + 1);
+}
+
+/* Ensure the file has at least numberOfPages pages */
+RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
+    }
     
-    // Allocate memory for empty page
-    emptyPage = (char *)calloc(PAGE_SIZE, sizeof(char));
-    if (emptyPage == NULL) {
-        THROW(RC_WRITE_FAILED, "Memory allocation failed");
+    // Grow the file in one step; the new pages read back as zeros
+    return extendFile(fHandle, numberOfPages);
+}
+
+/* Allocate room for numberOfPages pages in one step without adding them to
+ * the page count. writeBlocks may fill the reserved pages, and ensureCapacity
+ * later publishes them with a single header write. A numberOfPages at or
+ * below the page count gives the unused reservation back. */
+RC reserveBlocks(int numberOfPages, SM_FileHandle *fHandle) {
+    SM_FileInfo *info;
+    int rc;
+    
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
     }
     
-    // Seek to end of file
-    if (fseek(fp, 0, SEEK_END) != 0) {
-        free(emptyPage);
-        THROW(RC_WRITE_FAILED, "Could not seek to end of file");
+    info = (SM_FileInfo *)fHandle->mgmtInfo;
+    pthread_mutex_lock(&cacheLock);
+    
+    if (numberOfPages <= info->totalNumPages) {
+        if (info->reservedPages > 0 &&
+            ftruncate(info->fd, pageOffset(fHandle, info->totalNumPages)) != 0) {
+            pthread_mutex_unlock(&cacheLock);
+            THROW(RC_WRITE_FAILED, "Could not release reserved pages");
+        }
+        info->reservedPages = 0;
+    } else if (numberOfPages > info->reservedPages) {
+        // real blocks where the filesystem supports it, a sparse tail otherwise
+        off_t start = pageOffset(fHandle, info->totalNumPages);
+        rc = posix_fallocate(info->fd, start, pageOffset(fHandle, numberOfPages) - start);
+        if (rc != 0 && ftruncate(info->fd, pageOffset(fHandle, numberOfPages)) != 0) {
+            pthread_mutex_unlock(&cacheLock);
+            THROW(RC_WRITE_FAILED, "Could not reserve pages");
+        }
+        info->reservedPages = numberOfPages;
     }
     
-    // Write empty page
-    bytesWritten = fwrite(emptyPage, sizeof(char), PAGE_SIZE, fp);
+    fHandle->totalNumPages = info->totalNumPages;
+    pthread_mutex_unlock(&cacheLock);
     
-    free(emptyPage);
+    return RC_OK;
+}
+
+/************************************************************
+ * FREE-SPACE MAP
+ ************************************************************/
+
+/* Release a page: its blocks are punched out of the file and it reads as
+ * zeros until written again or handed out by allocatePage. The punched range
+ * reaches into the filesystem blocks shared with free neighbours, so runs of
+ * freed pages release whole blocks even when pages are not block aligned. */
+RC freePage(int pageNum, SM_FileHandle *fHandle) {
+    SM_FileInfo *info;
     
-    if (bytesWritten < PAGE_SIZE) {
-        THROW(RC_WRITE_FAILED, "Could not append empty block");
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
     }
     
-    // Update total number of pages
-    newTotalPages = fHandle->totalNumPages + 1;
-    fHandle->totalNumPages = newTotalPages;
+    info = (SM_FileInfo *)fHandle->mgmtInfo;
+    if (pageNum >= fHandle->totalNumPages) {
+        fHandle->totalNumPages = info->totalNumPages;
+    }
+    if (pageNum < 0 || pageNum >= fHandle->totalNumPages) {
+        THROW(RC_READ_NON_EXISTING_PAGE, "Page number out of bounds");
+    }
     
-    // Update metadata at the beginning of the file
-    currentPos = ftell(fp);
-    if (fseek(fp, 0, SEEK_SET) != 0) {
-        THROW(RC_WRITE_FAILED, "Could not seek to metadata");
+    pthread_mutex_lock(&info->mapLock);
+    if (pageNum < info->mapPages && testBit(info->freeBits, pageNum)) {
+        pthread_mutex_unlock(&info->mapLock);
+        return RC_OK;
+    }
+    if (!growMaps(info, pageNum)) {
+        pthread_mutex_unlock(&info->mapLock);
+        THROW(RC_WRITE_FAILED, "Memory allocation failed");
+    }
+    if (info->freeFd < 0) {
+        char *path = sidecarPath(info->path, ".free");
+        int magic = SM_FREE_MAGIC;
+        info->freeFd = path != NULL ? open(path, O_RDWR | O_CREAT | O_TRUNC, 0644) : -1;
+        free(path);
+        if (info->freeFd < 0 || pwrite(info->freeFd, &magic, sizeof(int), 0) != sizeof(int)) {
+            if (info->freeFd >= 0) close(info->freeFd);
+            info->freeFd = -1;
+            pthread_mutex_unlock(&info->mapLock);
+            THROW(RC_WRITE_FAILED, "Could not create free-space map");
+        }
     }
     
-    if (fwrite(&newTotalPages, sizeof(int), 1, fp) != 1) {
-        THROW(RC_WRITE_FAILED, "Could not update metadata");
+    /* widen to block boundaries, but never past the free neighbour: a block
+     * can span several pages (st_blksize is 128 KiB on ZFS, say) */
+    off_t start = pageOffset(fHandle, pageNum), end = pageOffset(fHandle, pageNum + 1);
+    off_t mask = info->blockSize - 1;
+    if (pageNum > 0 && pageNum - 1 < info->mapPages && testBit(info->freeBits, pageNum - 1)) {
+        off_t limit = pageOffset(fHandle, pageNum - 1);
+        start = (start & ~mask) > limit ? (start & ~mask) : limit;
+    }
+    if (pageNum + 1 < info->mapPages && testBit(info->freeBits, pageNum + 1)) {
+        off_t limit = pageOffset(fHandle, pageNum + 2);
+        end = ((end + mask) & ~mask) < limit ? ((end + mask) & ~mask) : limit;
+    }
+    int punched = 0;
+#ifdef FALLOC_FL_PUNCH_HOLE
+    punched = fallocate(info->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, start, end - start) == 0;
+#endif
+    if (!punched) {
+        // no hole punching here: keep the space, but the page still reads as zeros
+        char *zeros = (char *)calloc(1, fHandle->pageSize);
+        int written = zeros != NULL &&
+                      pwrite(info->fd, zeros, fHandle->pageSize, pageOffset(fHandle, pageNum)) == fHandle->pageSize;
+        free(zeros);
+        if (!written) {
+            pthread_mutex_unlock(&info->mapLock);
+            THROW(RC_WRITE_FAILED, "Could not release page");
+        }
     }
     
-    // Restore file position
-    fseek(fp, currentPos, SEEK_SET);
+    info->freeBits[pageNum >> 3] |= 1 << (pageNum & 7);
+    info->numFree++;
+    if (info->freeHint > (pageNum >> 3)) info->freeHint = pageNum >> 3;
+    markZeroPages(info, pageNum, pageNum + 1);
+    markChanged(info, pageNum, pageNum + 1);
+    persistFreeBit(info, pageNum);
+    pthread_mutex_unlock(&info->mapLock);
     
-    // Flush to ensure data is written
-    fflush(fp);
+    return RC_OK;
+}
+
+/* Hand out the lowest freed page, or append a page when none is free. The
+ * page reads as zeros either way. */
+RC allocatePage(int *pageNum, SM_FileHandle *fHandle) {
+    SM_FileInfo *info;
+    RC rc;
     
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
+    }
+    if (pageNum == NULL) {
+        THROW(RC_WRITE_FAILED, "Page number pointer is NULL");
+    }
+    
+    info = (SM_FileInfo *)fHandle->mgmtInfo;
+    pthread_mutex_lock(&info->mapLock);
+    if (info->numFree > 0) {
+        int byte = info->freeHint;
+        while (info->freeBits[byte] == 0) byte++;
+        int page = byte * 8 + __builtin_ctz(info->freeBits[byte]);
+        info->freeBits[page >> 3] &= ~(1 << (page & 7));
+        info->numFree--;
+        info->freeHint = byte;
+        persistFreeBit(info, page);
+        pthread_mutex_unlock(&info->mapLock);
+        *pageNum = page;
+        return RC_OK;
+    }
+    pthread_mutex_unlock(&info->mapLock);
+    
+    rc = extendFile(fHandle, fHandle->totalNumPages + 1);
+    if (rc != RC_OK) {
+        return rc;
+    }
+    *pageNum = fHandle->totalNumPages - 1;
     return RC_OK;
 }
 
-/* Ensure the file has at least numberOfPages pages */
-RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle) {
-    if (fHandle == NULL) {
+/* Number of freed pages not yet allocated again */
+int getNumFreePages(SM_FileHandle *fHandle) {
+    int numFree;
+    
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        return 0;
+    }
+    SM_FileInfo *info = (SM_FileInfo *)fHandle->mgmtInfo;
+    pthread_mutex_lock(&info->mapLock);
+    numFree = info->numFree;
+    pthread_mutex_unlock(&info->mapLock);
+    return numFree;
+}
+
+/************************************************************
+ * INCREMENTAL BACKUP
+ ************************************************************/
+
+/* Rewrite the changed-map sidecar from memory after a backup */
+static void rewriteChangedMap(SM_FileInfo *info) {
+    int header[2] = { SM_CHANGED_MAGIC, info->epoch };
+    int bytes = info->mapPages / 8;
+    
+    if (pwrite(info->changedFd, header, sizeof(header), 0) == sizeof(header) &&
+        (bytes == 0 || pwrite(info->changedFd, info->changedBits, bytes, SM_CHANGED_HEADER) == bytes)) {
+        ftruncate(info->changedFd, SM_CHANGED_HEADER + bytes);
+    }
+}
+
+/* Take the pages to back up out of the changed map: every page for a full
+ * backup, else those changed since the last one. Returns the page count. */
+static int startBackup(SM_FileInfo *info, int full, SM_BackupHeader *header) {
+    pthread_mutex_lock(&cacheLock);
+    int total = info->totalNumPages;
+    pthread_mutex_unlock(&cacheLock);
+    
+    pthread_mutex_lock(&info->mapLock);
+    if (info->pendingBits != NULL || (total > 0 && !growMaps(info, total - 1))) {
+        pthread_mutex_unlock(&info->mapLock);
+        return -1;
+    }
+    // changes made from here on belong to the next backup
+    if (!info->tracking) {
+        char *path = sidecarPath(info->path, ".changed");
+        info->changedFd = path != NULL ? open(path, O_RDWR | O_CREAT | O_TRUNC, 0644) : -1;
+        free(path);
+        if (info->changedFd < 0) {
+            pthread_mutex_unlock(&info->mapLock);
+            return -1;
+        }
+        rewriteChangedMap(info);
+        __atomic_store_n(&info->tracking, 1, __ATOMIC_RELAXED);
+        full = 1;
+    }
+    info->pendingBits = (unsigned char *)calloc((total + 7) / 8 + 1, 1);
+    if (info->pendingBits == NULL) {
+        pthread_mutex_unlock(&info->mapLock);
+        return -1;
+    }
+    info->pendingPages = total;
+    for (int p = 0; p < total; p++) {
+        if (full || testBit(info->changedBits, p)) {
+            info->pendingBits[p >> 3] |= 1 << (p & 7);
+        }
+        if (testBit(info->changedBits, p)) {
+            info->changedBits[p >> 3] &= ~(1 << (p & 7));
+            info->numChanged--;
+        }
+    }
+    header->baseEpoch = full ? 0 : info->epoch;
+    header->epoch = info->epoch + 1;
+    pthread_mutex_unlock(&info->mapLock);
+    return total;
+}
+
+/* Close the epoch once the backup is durable, or give its pages back to the
+ * changed map if it failed */
+static void finishBackup(SM_FileInfo *info, int ok) {
+    pthread_mutex_lock(&info->mapLock);
+    if (ok) {
+        info->epoch++;
+    } else {
+        for (int p = 0; p < info->pendingPages; p++) {
+            if (testBit(info->pendingBits, p) && !testBit(info->changedBits, p)) {
+                info->changedBits[p >> 3] |= 1 << (p & 7);
+                info->numChanged++;
+            }
+        }
+    }
+    free(info->pendingBits);
+    info->pendingBits = NULL;
+    info->pendingPages = 0;
+    rewriteChangedMap(info);
+    pthread_mutex_unlock(&info->mapLock);
+}
+
+/* Copy the pages of the backup in progress to out, in page order, as runs of
+ * adjacent pages that either all read as zeros (stored without data) or not.
+ * Pages are read with pread, leaving the caller's curPagePos alone. */
+static int writeBackupRuns(SM_FileHandle *fHandle, FILE *out, int total, char *buf, int *numPages) {
+    SM_FileInfo *info = (SM_FileInfo *)fHandle->mgmtInfo;
+    SM_BackupRun run;
+    int p = 0;
+    
+    while (p < total) {
+        if (!testBit(info->pendingBits, p)) {
+            p++;
+            continue;
+        }
+        run.start = p;
+        run.zero = pagesAreZero(info, p, 1);
+        run.count = 1;
+        while (p + run.count < total && run.count < SM_BACKUP_RUN_PAGES &&
+               testBit(info->pendingBits, p + run.count) &&
+               pagesAreZero(info, p + run.count, 1) == run.zero) {
+            run.count++;
+        }
+        if (fwrite(&run, sizeof(run), 1, out) != 1) return 0;
+        if (!run.zero) {
+            if (!transferPages(fHandle, run.start, run.count, buf, 0) ||
+                fwrite(buf, fHandle->pageSize, run.count, out) != (size_t)run.count) {
+                return 0;
+            }
+        }
+        *numPages += run.count;
+        p += run.count;
+    }
+    run.start = total;
+    run.count = 0;
+    run.zero = 0;
+    return fwrite(&run, sizeof(run), 1, out) == 1;
+}
+
+/* Back up a page file. A full backup copies every page; an incremental one
+ * copies only pages written or freed since the previous backup, so its I/O
+ * follows the churn rather than the file size (the first backup of a file
+ * is always full). Pages written while the backup runs go to the next one.
+ * The epoch only advances once the backup file is synced, so a failed or
+ * interrupted backup loses nothing. */
+RC backupPageFile(SM_FileHandle *fHandle, char *backupFileName, int incremental) {
+    SM_BackupHeader header;
+    SM_FileInfo *info;
+    
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
         THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
     }
+    if (backupFileName == NULL) {
+        THROW(RC_FILE_NOT_FOUND, "Backup file name is NULL");
+    }
     
-    // Append empty blocks until we reach the desired capacity
-    while (fHandle->totalNumPages < numberOfPages) {
-        RC rc = appendEmptyBlock(fHandle);
+    info = (SM_FileInfo *)fHandle->mgmtInfo;
+    FILE *out = fopen(backupFileName, "wb");
+    char *buf = (char *)malloc((size_t)SM_BACKUP_RUN_PAGES * fHandle->pageSize);
+    if (out == NULL || buf == NULL) {
+        if (out != NULL) fclose(out);
+        free(buf);
+        THROW(RC_WRITE_FAILED, "Could not create backup file");
+    }
+    
+    memset(&header, 0, sizeof(header));
+    int total = startBackup(info, !incremental, &header);
+    if (total < 0) {
+        fclose(out);
+        remove(backupFileName);
+        free(buf);
+        THROW(RC_WRITE_FAILED, "Could not start backup");
+    }
+    header.magic = SM_BACKUP_MAGIC;
+    header.version = SM_BACKUP_VERSION;
+    header.pageSize = fHandle->pageSize;
+    header.headerSize = fHandle->headerSize;
+    header.totalNumPages = total;
+    
+    int ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+             writeBackupRuns(fHandle, out, total, buf, &header.numPages);
+    // the page count goes into the header once the runs are written
+    ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1 &&
+         fflush(out) == 0 && fsync(fileno(out)) == 0;
+    ok = (fclose(out) == 0) && ok;
+    free(buf);
+    
+    finishBackup(info, ok);
+    if (!ok) {
+        remove(backupFileName);
+        THROW(RC_WRITE_FAILED, "Could not write backup");
+    }
+    return RC_OK;
+}
+
+/* Epoch a restored file has reached, or -1 when it is not a complete restore */
+static int readRestoredEpoch(const char *pageFileName) {
+    char *path = sidecarPath(pageFileName, ".restored");
+    int header[2] = { 0, -1 };
+    FILE *fp = path != NULL ? fopen(path, "rb") : NULL;
+    
+    free(path);
+    if (fp == NULL) return -1;
+    if (fread(header, sizeof(header), 1, fp) != 1 || header[0] != SM_RESTORED_MAGIC) header[1] = -1;
+    fclose(fp);
+    return header[1];
+}
+
+/* Record the epoch a restored file has reached; epoch < 0 forgets it, so a
+ * restore that stops half way accepts no further incrementals */
+static int writeRestoredEpoch(const char *pageFileName, int epoch) {
+    char *path = sidecarPath(pageFileName, ".restored");
+    int header[2] = { SM_RESTORED_MAGIC, epoch };
+    int ok = 0;
+    
+    if (path == NULL) return 0;
+    if (epoch < 0) {
+        ok = unlink(path) == 0 || errno == ENOENT;
+    } else {
+        FILE *fp = fopen(path, "wb");
+        ok = fp != NULL && fwrite(header, sizeof(header), 1, fp) == 1;
+        ok = (fp == NULL || fclose(fp) == 0) && ok;
+    }
+    free(path);
+    return ok;
+}
+
+/* Apply a backup to a page file: a full backup recreates it, an incremental
+ * one is applied on top of the previous backups, in the order taken. An
+ * incremental whose base is not the epoch the file was restored to fails
+ * with RC_BACKUP_OUT_OF_ORDER and leaves the file untouched. */
+RC restoreBackup(char *backupFileName, char *pageFileName) {
+    SM_BackupHeader header;
+    SM_BackupRun run;
+    SM_FileHandle fh;
+    RC rc;
+    
+    if (backupFileName == NULL || pageFileName == NULL) {
+        THROW(RC_FILE_NOT_FOUND, "File name is NULL");
+    }
+    
+    FILE *in = fopen(backupFileName, "rb");
+    if (in == NULL) {
+        THROW(RC_FILE_NOT_FOUND, "Backup file not found");
+    }
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != SM_BACKUP_MAGIC ||
+        header.version != SM_BACKUP_VERSION || header.totalNumPages < 0) {
+        fclose(in);
+        THROW(RC_READ_NON_EXISTING_PAGE, "Not a backup file");
+    }
+    
+    if (header.baseEpoch != 0 && readRestoredEpoch(pageFileName) != header.baseEpoch) {
+        fclose(in);
+        THROW(RC_BACKUP_OUT_OF_ORDER, "Backup does not follow the restored epoch");
+    }
+    if (!writeRestoredEpoch(pageFileName, -1)) {
+        fclose(in);
+        THROW(RC_WRITE_FAILED, "Could not reset the restored epoch");
+    }
+    
+    if (header.baseEpoch == 0) {
+        rc = header.headerSize == LEGACY_HEADER_SIZE ? createPageFile(pageFileName)
+                                                      : createPageFileWithSize(pageFileName, header.pageSize);
         if (rc != RC_OK) {
+            fclose(in);
             return rc;
         }
     }
+    rc = openPageFile(pageFileName, &fh);
+    if (rc != RC_OK) {
+        fclose(in);
+        return rc;
+    }
+    if (fh.pageSize != header.pageSize) {
+        closePageFile(&fh);
+        fclose(in);
+        THROW(RC_INVALID_PAGE_SIZE, "Backup page size does not match the file");
+    }
+    
+    char *buf = (char *)malloc((size_t)SM_BACKUP_RUN_PAGES * header.pageSize);
+    rc = buf != NULL ? ensureCapacity(header.totalNumPages, &fh) : RC_WRITE_FAILED;
+    while (rc == RC_OK) {
+        if (fread(&run, sizeof(run), 1, in) != 1 || run.count < 0 || run.count > SM_BACKUP_RUN_PAGES ||
+            run.start < 0 || run.start + run.count > header.totalNumPages) {
+            rc = RC_READ_NON_EXISTING_PAGE;
+            break;
+        }
+        if (run.count == 0) break;
+        if (run.zero) {
+            // a fresh file already reads as zeros there
+            if (header.baseEpoch == 0) continue;
+            memset(buf, 0, (size_t)run.count * header.pageSize);
+        } else if (fread(buf, header.pageSize, run.count, in) != (size_t)run.count) {
+            rc = RC_READ_NON_EXISTING_PAGE;
+            break;
+        }
+        rc = writeBlocks(run.start, run.count, &fh, buf);
+    }
+    
+    free(buf);
+    fclose(in);
+    closePageFile(&fh);
+    if (rc == RC_OK && !writeRestoredEpoch(pageFileName, header.epoch)) {
+        THROW(RC_WRITE_FAILED, "Could not record the restored epoch");
+    }
+    return rc;
+}
+
+/* Pages the next incremental backup would copy */
+int getNumChangedPages(SM_FileHandle *fHandle) {
+    int numChanged;
+    
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        return 0;
+    }
+    SM_FileInfo *info = (SM_FileInfo *)fHandle->mgmtInfo;
+    pthread_mutex_lock(&info->mapLock);
+    numChanged = info->tracking ? info->numChanged : info->totalNumPages;
+    pthread_mutex_unlock(&info->mapLock);
+    return numChanged;
+}
+
+/************************************************************
+ * ACCESS HINTS
+ ************************************************************/
+
+/* Tell the kernel how the file will be accessed. The advice applies to the
+ * descriptor, which is shared by every handle on the same file. */
+RC setAccessHint(SM_FileHandle *fHandle, SM_AccessHint hint) {
+    int advice;
+    
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "File handle not initialized");
+    }
+    
+    switch (hint) {
+        case SM_HINT_NORMAL: advice = POSIX_FADV_NORMAL; break;
+        case SM_HINT_SEQUENTIAL: advice = POSIX_FADV_SEQUENTIAL; break;
+        case SM_HINT_RANDOM: advice = POSIX_FADV_RANDOM; break;
+        case SM_HINT_WILLNEED: advice = POSIX_FADV_WILLNEED; break;
+        case SM_HINT_DONTNEED: advice = POSIX_FADV_DONTNEED; break;
+        default: THROW(RC_FILE_HANDLE_NOT_INIT, "Unknown access hint");
+    }
+    
+    // Only the page area; offset 0 length 0 would mean the whole file
+    if (posix_fadvise(((SM_FileInfo *)fHandle->mgmtInfo)->fd, fHandle->headerSize, 0, advice) != 0) {
+        THROW(RC_FILE_HANDLE_NOT_INIT, "Could not apply access hint");
+    }
+    fHandle->accessHint = hint;
     
     return RC_OK;
-}
\ No newline at end of file
+}
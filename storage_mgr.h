@@ -3,16 +3,36 @@
 
 #include "dberror.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /************************************************************
  *                    handle data structures                *
  ************************************************************/
+/* access patterns for setAccessHint, mapped to posix_fadvise */
+typedef enum SM_AccessHint {
+	SM_HINT_NORMAL = 0,
+	SM_HINT_SEQUENTIAL = 1,
+	SM_HINT_RANDOM = 2,
+	SM_HINT_WILLNEED = 3,
+	SM_HINT_DONTNEED = 4
+} SM_AccessHint;
+
 typedef struct SM_FileHandle {
 	char *fileName;
 	int totalNumPages;
 	int curPagePos;
 	void *mgmtInfo;
+	int pageSize;		// bytes per page, from the file header
+	int headerSize;		// offset of page 0
+	SM_AccessHint accessHint;
 } SM_FileHandle;
 
+/* page sizes accepted by createPageFileWithSize: powers of two in this range */
+#define SM_MIN_PAGE_SIZE 4096
+#define SM_MAX_PAGE_SIZE (1024 * 1024)
+
 typedef char* SM_PageHandle;
 
 /************************************************************
@@ -21,6 +41,7 @@ typedef char* SM_PageHandle;
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createPageFileWithSize (char *fileName, int pageSize);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
@@ -33,11 +54,39 @@ extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+/* count consecutive pages in one I/O; memPages holds count * pageSize bytes */
+extern RC readBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle memPages);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+/* allocate pages for writeBlocks without counting them until ensureCapacity */
+extern RC reserveBlocks (int numberOfPages, SM_FileHandle *fHandle);
+
+/* free-space map: freed pages read as zeros and are reused by allocatePage,
+ * which appends a page when none is free; writing a freed page reuses it */
+extern RC freePage (int pageNum, SM_FileHandle *fHandle);
+extern RC allocatePage (int *pageNum, SM_FileHandle *fHandle);
+extern int getNumFreePages (SM_FileHandle *fHandle);
+
+/* incremental backup: after the first (full) backup of a file, pages written
+ * or freed are tracked in a "<fileName>.changed" map until the next one */
+extern RC backupPageFile (SM_FileHandle *fHandle, char *backupFileName, int incremental);
+extern RC restoreBackup (char *backupFileName, char *pageFileName);
+extern int getNumChangedPages (SM_FileHandle *fHandle);
+
+/* kernel access hint for the file behind the handle */
+extern RC setAccessHint (SM_FileHandle *fHandle, SM_AccessHint hint);
+
+/* file handle cache: open files are shared by path and closed lazily */
+extern void closeIdleFiles (void);
+extern void getFileCacheStats (int *openFiles, int *hits, int *misses);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
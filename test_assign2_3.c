@@ -0,0 +1,1634 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "test_helper.h"
+#include "access_trace.h"
+#include "bulk_loader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// var to store the current test's name
+char *testName;
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected,bm,message)                    \
+do {                                    \
+char *real;                                \
+char *_exp = (char *) (expected);                                   \
+real = sprintPoolContent(bm);                    \
+if (strcmp((_exp),real) != 0)                    \
+{                                    \
+printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+free(real);                            \
+exit(1);                            \
+}                                    \
+printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+free(real);                                \
+} while(0)
+
+// test and helper methods
+static void createFilledPageFile(char *fileName, int num);
+static void checkPageContent(BM_PageHandle *h);
+
+static void testVictimCache (void);
+static void testAccessStrategy (void);
+static void testAccessTrace (void);
+static void testPoolStats (void);
+static void testWarmRestart (void);
+static void testCheckpoint (void);
+static void testPinNewPage (void);
+static void testCleanEviction (void);
+static void testAdaptiveStrategy (void);
+static void testPageSize (void);
+static void testFileCache (void);
+static void testMultiBlockIO (void);
+static void testBulkLoad (void);
+static void testL2Cache (void);
+static void testPartitions (void);
+static void testPriorityPins (void);
+static void testPinWait (void);
+static void testSampledEviction (void);
+static void testAdmissionFilter (void);
+static void testMissRatioCurve (void);
+static void testFreePages (void);
+static void testIncrementalBackup (void);
+static void testConcurrentMaintenance (void);
+
+// main method
+int
+main (void)
+{
+    initStorageManager();
+    testName = "";
+
+    testVictimCache();
+    testAccessStrategy();
+    testAccessTrace();
+    testPoolStats();
+    testWarmRestart();
+    testCheckpoint();
+    testPinNewPage();
+    testCleanEviction();
+    testAdaptiveStrategy();
+    testPageSize();
+    testFileCache();
+    testMultiBlockIO();
+    testBulkLoad();
+    testL2Cache();
+    testPartitions();
+    testPriorityPins();
+    testPinWait();
+    testSampledEviction();
+    testAdmissionFilter();
+    testMissRatioCurve();
+    testFreePages();
+    testIncrementalBackup();
+    testConcurrentMaintenance();
+    return 0;
+}
+
+// create a page file with num pages whose content is "Page-X"
+void
+createFilledPageFile(char *fileName, int num)
+{
+    SM_FileHandle fh;
+    char *page = (char *) calloc(PAGE_SIZE, sizeof(char));
+    int i;
+
+    CHECK(createPageFile(fileName));
+    CHECK(openPageFile(fileName, &fh));
+    CHECK(ensureCapacity(num, &fh));
+    for (i = 0; i < num; i++)
+    {
+        sprintf(page, "%s-%i", "Page", i);
+        CHECK(writeBlock(i, &fh, page));
+    }
+    CHECK(closePageFile(&fh));
+    free(page);
+}
+
+void
+checkPageContent(BM_PageHandle *h)
+{
+    char expected[64];
+
+    sprintf(expected, "%s-%i", "Page", h->pageNum);
+    ASSERT_EQUALS_STRING(expected, h->data, "page content");
+}
+
+// evicted pages are served from the compressed victim cache
+void
+testVictimCache (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    int i, round;
+    testName = "Testing compressed victim cache";
+
+    createFilledPageFile("testbuffer.bin", 20);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+    CHECK(setVictimCacheSize(bm, 64 * 1024));
+
+    // mostly empty pages compress far below PAGE_SIZE, so all 20 pages fit
+    for (round = 0; round < 3; round++)
+        for (i = 0; i < 20; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            checkPageContent(h);
+            if (round == 1 && i % 2 == 0)
+            {
+                sprintf(h->data + 32, "dirty-%i", i);
+                CHECK(markDirty(bm, h));
+            }
+            CHECK(unpinPage(bm, h));
+        }
+
+    ASSERT_EQUALS_INT(20, getNumReadIO(bm), "only the first round reads from disk");
+    ASSERT_EQUALS_INT(40, getNumVictimCacheHits(bm), "later rounds hit the victim cache");
+    ASSERT_EQUALS_INT(20, getNumVictimCacheMisses(bm), "first round misses the victim cache");
+
+    // dirty pages were written back and the cache holds their new content
+    CHECK(pinPage(bm, h, 4));
+    ASSERT_EQUALS_STRING("dirty-4", h->data + 32, "modified page survives the victim cache");
+    CHECK(unpinPage(bm, h));
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a sequential scan through a strategy ring leaves the hot set resident
+void
+testAccessStrategy (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_AccessStrategy scan;
+    int i;
+    testName = "Testing scan-resistant access strategy";
+
+    createFilledPageFile("testbuffer.bin", 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 10, RS_LRU, NULL));
+
+    // hot set
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+
+    CHECK(initAccessStrategy(bm, &scan, BM_HINT_SEQUENTIAL, 0));
+    for (i = 10; i < 100; i++)
+    {
+        CHECK(pinPageWithStrategy(bm, h, i, &scan));
+        checkPageContent(h);
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(freeAccessStrategy(&scan));
+    ASSERT_EQUALS_INT(96, getNumReadIO(bm), "scan reads every page once");
+
+    // hot set survived the scan
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        checkPageContent(h);
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(96, getNumReadIO(bm), "hot set still resident after scan");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// pin/unpin/markDirty calls are recorded in order
+void
+testAccessTrace (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    const AT_Op ops[] = { AT_PIN, AT_MARK_DIRTY, AT_UNPIN, AT_PIN, AT_UNPIN };
+    const PageNumber pages[] = { 3, 3, 3, 7, 7 };
+    AT_Record rec;
+    FILE *trace;
+    int i;
+    testName = "Testing access trace recording";
+
+    createFilledPageFile("testbuffer.bin", 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    CHECK(startAccessTrace(bm, "testtrace.bin"));
+
+    CHECK(pinPage(bm, h, 3));
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 7));
+    CHECK(unpinPage(bm, h));
+    CHECK(stopAccessTrace(bm));
+    CHECK(pinPage(bm, h, 8));
+    CHECK(unpinPage(bm, h));
+
+    trace = openAccessTraceReader("testtrace.bin");
+    ASSERT_TRUE(trace != NULL, "trace file has a valid header");
+    for (i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(readAccessRecord(trace, &rec), "record present");
+        ASSERT_EQUALS_INT(ops[i], rec.op, "record operation");
+        ASSERT_EQUALS_INT(pages[i], rec.pageNum, "record page");
+    }
+    ASSERT_TRUE(!readAccessRecord(trace, &rec), "nothing recorded after stopAccessTrace");
+    fclose(trace);
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    remove("testtrace.bin");
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// hits, misses, evictions and flushes are counted
+void
+testPoolStats (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolStats stats;
+    PageNumber contents[3];
+    int fixCounts[3];
+    long long reads = 0;
+    int i;
+    testName = "Testing pool statistics";
+
+    createFilledPageFile("testbuffer.bin", 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+    // pages 0-2 dirty, then 3-5 evict them, then 3 is a hit
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        if (i < 3)
+            CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(pinPage(bm, h, 3));
+    CHECK(pinPage(bm, h, 4));
+    CHECK(pinPage(bm, h, 5));
+    ASSERT_ERROR(pinPage(bm, h, 6), "pool full of pinned pages");
+    CHECK(markDirty(bm, h));
+    CHECK(forceFlushPool(bm));
+
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(3, (int) stats.hits, "hits");
+    ASSERT_EQUALS_INT(7, (int) stats.misses, "misses");
+    ASSERT_EQUALS_INT(3, (int) stats.dirtyEvictions, "dirty evictions");
+    ASSERT_EQUALS_INT(0, (int) stats.cleanEvictions, "clean evictions");
+    ASSERT_EQUALS_INT(1, (int) stats.pinFailures, "pin failures");
+    ASSERT_EQUALS_INT(1, (int) stats.flushes, "flushes");
+    ASSERT_EQUALS_INT(1, (int) stats.flushedPages, "flushed pages");
+    ASSERT_EQUALS_INT(6, (int) stats.readIO, "read I/Os");
+    ASSERT_EQUALS_INT(4, (int) stats.writeIO, "write I/Os");
+    for (i = 0; i < BM_LATENCY_BUCKETS; i++)
+        reads += stats.readLatency[i];
+    ASSERT_EQUALS_INT(6, (int) reads, "every read lands in the latency histogram");
+
+    CHECK(getFrameContentsInto(bm, contents));
+    CHECK(getFixCountsInto(bm, fixCounts));
+    for (i = 0; i < 3; i++)
+    {
+        ASSERT_EQUALS_INT(3 + i, contents[i], "frame contents snapshot");
+        ASSERT_EQUALS_INT(1, fixCounts[i], "fix count snapshot");
+    }
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// resident pages survive a restart, and prewarm loads a range unpinned
+void
+testWarmRestart (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    const int pages[] = { 5, 9, 2, 7 };
+    int i;
+    testName = "Testing warm restart and prewarm";
+
+    createFilledPageFile("testbuffer.bin", 20);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, pages[i]));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(setWarmRestart(bm, TRUE));
+    CHECK(shutdownBufferPool(bm));
+
+    // reloaded in page order before the first pin
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+    ASSERT_EQUALS_POOL("[2 0],[5 0],[7 0],[9 0]", bm, "resident pages reloaded in page order");
+    ASSERT_EQUALS_INT(4, getNumReadIO(bm), "reload reads each page once");
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, pages[i]));
+        checkPageContent(h);
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(4, getNumReadIO(bm), "reloaded pages are hits");
+
+    // LRU order survived: 5 was the least recently used page before the restart
+    CHECK(pinPage(bm, h, 11));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[2 0],[11 0],[7 0],[9 0]", bm, "replacement metadata restored");
+    CHECK(shutdownBufferPool(bm));
+
+    // the sidecar is consumed by the reload
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+    ASSERT_EQUALS_INT(0, getNumReadIO(bm), "no sidecar without setWarmRestart");
+    CHECK(prewarm(bm, 12, 30));
+    ASSERT_EQUALS_POOL("[12 0],[13 0],[14 0],[15 0]", bm, "prewarm fills the pool from firstPage");
+    CHECK(shutdownBufferPool(bm));
+
+    // a smaller pool reloads the most recently used pages, not the first frames
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, pages[i]));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(setWarmRestart(bm, TRUE));
+    CHECK(shutdownBufferPool(bm));
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU, NULL));
+    ASSERT_EQUALS_POOL("[2 0],[7 0]", bm, "most recent pages kept");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// dirty pages are checkpointed oldest first, within the rate cap
+void
+testCheckpoint (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolStats stats;
+    const int dirtyOrder[] = { 3, 1, 4 };
+    int i;
+    testName = "Testing dirty list and incremental checkpoints";
+
+    createFilledPageFile("testbuffer.bin", 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 5, RS_FIFO, NULL));
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(pinPage(bm, h, dirtyOrder[i]));
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(3, getNumDirtyPages(bm), "three dirty pages");
+
+    // one page per second: only the oldest dirty page fits the initial token
+    CHECK(beginCheckpoint(bm, 1));
+    ASSERT_EQUALS_POOL("[0 0],[1x0],[2 0],[3 0],[4x0]", bm, "oldest dirty page written first");
+    ASSERT_EQUALS_INT(2, getCheckpointPending(bm), "two pages left below the horizon");
+
+    // pages dirtied after the checkpoint started are not part of it
+    CHECK(pinPage(bm, h, 0));
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(2, getCheckpointPending(bm), "new dirty page is past the horizon");
+
+    CHECK(pauseCheckpoint(bm));
+    CHECK(checkpointStep(bm));
+    CHECK(resumeCheckpoint(bm));
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "no writes while paused or without tokens");
+
+    // uncapped, the rest of the horizon is written at once
+    CHECK(beginCheckpoint(bm, 0));
+    ASSERT_EQUALS_INT(0, getCheckpointPending(bm), "checkpoint complete");
+    ASSERT_EQUALS_INT(0, getNumDirtyPages(bm), "pool clean");
+    ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "each dirty page written once");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(4, (int) stats.checkpointPages, "checkpoint pages counted");
+
+    // forceFlushPool drains the same list
+    CHECK(pinPage(bm, h, 2));
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(forceFlushPool(bm));
+    ASSERT_EQUALS_INT(0, getNumDirtyPages(bm), "flushed");
+    ASSERT_EQUALS_INT(5, getNumWriteIO(bm), "flush wrote the one dirty page");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// new pages are pinned without a read and reach the file when flushed
+void
+testPinNewPage (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    PageNumber pageNum;
+    char *page = (char *) malloc(PAGE_SIZE);
+    int i;
+    testName = "Testing pinNewPage";
+
+    createFilledPageFile("testbuffer.bin", 3);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_FIFO, NULL));
+
+    for (i = 3; i < 6; i++)
+    {
+        CHECK(pinNewPage(bm, h, &pageNum));
+        ASSERT_EQUALS_INT(i, pageNum, "page numbers continue after the file");
+        ASSERT_EQUALS_INT(i, h->pageNum, "handle holds the new page");
+        ASSERT_EQUALS_STRING("", h->data, "new page is zeroed");
+        sprintf(h->data, "%s-%i", "Page", i);
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[5x0],[4x0]", bm, "new pages are dirty");
+    ASSERT_EQUALS_INT(0, getNumReadIO(bm), "no reads for new pages");
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "page 3 written once, on eviction");
+
+    CHECK(pinPage(bm, h, 3));
+    checkPageContent(h);
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    // the first write grew the file by a whole extent
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_TRUE(fh.totalNumPages >= 6 && fh.totalNumPages % 16 == 0, "file extended in extents");
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(readBlock(i, &fh, page));
+        h->pageNum = i;
+        h->data = page;
+        checkPageContent(h);
+    }
+    CHECK(closePageFile(&fh));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(page);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// within the eviction window clean frames are evicted before dirty ones
+void
+testCleanEviction (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolStats stats;
+    int i;
+    testName = "Testing clean-preferring eviction";
+
+    createFilledPageFile("testbuffer.bin", 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+    CHECK(setEvictionWindow(bm, 3));
+
+    // pages 0 and 1 are the least recently used, and dirty
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        if (i < 2)
+            CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(pinPage(bm, h, 4));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[0x0],[1x0],[4 0],[3 0]", bm, "clean page 2 evicted before dirty 0 and 1");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "no write on the miss");
+
+    // 3 is outside the window {0, 1, 4}, which holds only dirty pages after this
+    CHECK(pinPage(bm, h, 4));
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 3));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 5));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[5 0],[1x0],[4x0],[3 0]", bm, "dirty fallback takes the best candidate");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(1, (int) stats.dirtyFallbacks, "one dirty fallback");
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "fallback wrote the victim");
+
+    // window 0 restores plain LRU: 1 is evicted although 3 is clean
+    CHECK(setEvictionWindow(bm, 0));
+    CHECK(pinPage(bm, h, 6));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[5 0],[6 0],[4x0],[3 0]", bm, "plain LRU order");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a looping scan defeats LRU, so the adaptive pool moves to a better strategy
+void
+testAdaptiveStrategy (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolStats stats;
+    int i;
+    testName = "Testing adaptive strategy selection";
+
+    createFilledPageFile("testbuffer.bin", 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_ADAPTIVE, NULL));
+    ASSERT_EQUALS_INT(RS_LRU, getLiveStrategy(bm), "starts with LRU");
+
+    for (i = 0; i < 2000; i++)
+    {
+        CHECK(pinPage(bm, h, i % 6));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_TRUE(getLiveStrategy(bm) == RS_LFU || getLiveStrategy(bm) == RS_LRU_K,
+                "switched to a frequency-based strategy");
+    ASSERT_TRUE(stats.strategySwitches >= 1, "switch counted");
+    ASSERT_TRUE(stats.hits > 0, "loop pages hit after the switch");
+
+    // a uniform stream afterwards must not make the strategy flip-flop
+    resetPoolStats(bm);
+    for (i = 0; i < 2000; i++)
+    {
+        CHECK(pinPage(bm, h, (i * 7) % 10));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_TRUE(stats.strategySwitches <= 1, "hysteresis limits switching");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// the page size recorded at creation is used by the storage manager and the pool
+void
+testPageSize (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    const int pageSize = 16384;
+    char *page = (char *) calloc(pageSize, sizeof(char));
+    int i;
+    testName = "Testing per-file page size";
+
+    ASSERT_EQUALS_INT(RC_INVALID_PAGE_SIZE, createPageFileWithSize("testbuffer.bin", 3000), "size must be a power of two");
+    ASSERT_EQUALS_INT(RC_INVALID_PAGE_SIZE, createPageFileWithSize("testbuffer.bin", 2048), "size below the minimum");
+
+    CHECK(createPageFileWithSize("testbuffer.bin", pageSize));
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(pageSize, fh.pageSize, "page size read from the header");
+    ASSERT_EQUALS_INT(1, fh.totalNumPages, "one initial page");
+    CHECK(ensureCapacity(4, &fh));
+    for (i = 0; i < 4; i++)
+    {
+        memset(page, 'a' + i, pageSize);
+        CHECK(writeBlock(i, &fh, page));
+    }
+    CHECK(closePageFile(&fh));
+
+    // frames take the file's page size
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU, NULL));
+    ASSERT_EQUALS_INT(pageSize, getPoolPageSize(bm), "pool page size");
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        ASSERT_TRUE(h->data[0] == 'a' + i && h->data[pageSize - 1] == 'a' + i, "whole page read");
+        h->data[pageSize - 1] = 'A' + i;
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(4, fh.totalNumPages, "page count kept in the header");
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(readBlock(i, &fh, page));
+        ASSERT_TRUE(page[0] == 'a' + i && page[pageSize - 1] == 'A' + i, "whole page written");
+    }
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    // files from createPageFile keep the legacy 4 KB layout
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(PAGE_SIZE, fh.pageSize, "legacy page size");
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(page);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// page files are shared through the handle cache and closed lazily
+void
+testFileCache (void)
+{
+    SM_FileHandle fh1, fh2;
+    char *page = (char *) calloc(PAGE_SIZE, sizeof(char));
+    int openFiles, hits, misses, hits0, misses0;
+    testName = "Testing file handle cache";
+
+    closeIdleFiles();
+    getFileCacheStats(&openFiles, &hits0, &misses0);
+    ASSERT_EQUALS_INT(0, openFiles, "no idle files after closeIdleFiles");
+
+    createFilledPageFile("testbuffer.bin", 2);
+    CHECK(openPageFile("testbuffer.bin", &fh1));
+    CHECK(openPageFile("testbuffer.bin", &fh2));
+    getFileCacheStats(&openFiles, &hits, &misses);
+    ASSERT_EQUALS_INT(1, openFiles, "both handles share one descriptor");
+    ASSERT_TRUE(hits - hits0 >= 2, "reopens are served from the cache");
+    ASSERT_EQUALS_INT(1, misses - misses0, "only the first open misses");
+
+    // growth and writes through one handle are visible through the other
+    CHECK(ensureCapacity(3, &fh1));
+    strcpy(page, "Page-2");
+    CHECK(writeBlock(2, &fh1, page));
+    memset(page, 0, PAGE_SIZE);
+    CHECK(readBlock(2, &fh2, page));
+    ASSERT_EQUALS_STRING("Page-2", page, "shared file contents");
+    ASSERT_EQUALS_INT(3, fh2.totalNumPages, "page count refreshed");
+
+    CHECK(closePageFile(&fh1));
+    CHECK(closePageFile(&fh2));
+    getFileCacheStats(&openFiles, NULL, NULL);
+    ASSERT_EQUALS_INT(1, openFiles, "closed file stays cached");
+
+    // a cached file reopens with its header fields and without a miss
+    getFileCacheStats(NULL, NULL, &misses0);
+    CHECK(openPageFile("testbuffer.bin", &fh1));
+    getFileCacheStats(NULL, NULL, &misses);
+    ASSERT_EQUALS_INT(misses0, misses, "reopen hits the cache");
+    ASSERT_EQUALS_INT(3, fh1.totalNumPages, "cached page count");
+    CHECK(closePageFile(&fh1));
+
+    // destroying the file drops its entry
+    CHECK(destroyPageFile("testbuffer.bin"));
+    getFileCacheStats(&openFiles, NULL, NULL);
+    ASSERT_EQUALS_INT(0, openFiles, "destroyed file closed");
+    ASSERT_TRUE(openPageFile("testbuffer.bin", &fh1) != RC_OK, "destroyed file cannot be opened");
+
+    free(page);
+    TEST_DONE();
+}
+
+// runs of pages move in one call, and access hints reach the kernel
+void
+testMultiBlockIO (void)
+{
+    SM_FileHandle fh;
+    char *pages = (char *) calloc(4 * PAGE_SIZE, sizeof(char));
+    char expected[64];
+    int i;
+    testName = "Testing multi-block reads and writes";
+
+    createFilledPageFile("testbuffer.bin", 8);
+    CHECK(openPageFile("testbuffer.bin", &fh));
+
+    CHECK(readBlocks(2, 4, &fh, pages));
+    for (i = 0; i < 4; i++)
+    {
+        sprintf(expected, "%s-%i", "Page", 2 + i);
+        ASSERT_EQUALS_STRING(expected, pages + i * PAGE_SIZE, "page read in its slot");
+    }
+    ASSERT_EQUALS_INT(5, getBlockPos(&fh), "position at the last page read");
+
+    for (i = 0; i < 3; i++)
+        sprintf(pages + i * PAGE_SIZE, "%s-%i", "Block", 5 + i);
+    CHECK(writeBlocks(5, 3, &fh, pages));
+    CHECK(readBlock(6, &fh, pages));
+    ASSERT_EQUALS_STRING("Block-6", pages, "page written in its slot");
+
+    ASSERT_TRUE(readBlocks(6, 3, &fh, pages) != RC_OK, "range past the end");
+    ASSERT_TRUE(writeBlocks(-1, 2, &fh, pages) != RC_OK, "negative start");
+    ASSERT_TRUE(readBlocks(0, 0, &fh, pages) != RC_OK, "empty range");
+
+    CHECK(setAccessHint(&fh, SM_HINT_SEQUENTIAL));
+    CHECK(setAccessHint(&fh, SM_HINT_WILLNEED));
+    CHECK(setAccessHint(&fh, SM_HINT_DONTNEED));
+    CHECK(setAccessHint(&fh, SM_HINT_RANDOM));
+    ASSERT_EQUALS_INT(SM_HINT_RANDOM, fh.accessHint, "hint recorded on the handle");
+    CHECK(setAccessHint(&fh, SM_HINT_NORMAL));
+
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(pages);
+    TEST_DONE();
+}
+
+// bulk loads bypass the pool and publish the page count once at the end
+void
+testBulkLoad (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BL_BulkLoad bl;
+    SM_FileHandle fh;
+    PageNumber newPage;
+    char *page;
+    int i;
+    testName = "Testing bulk loads";
+
+    createFilledPageFile("testbuffer.bin", 4);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_FIFO, NULL));
+    CHECK(pinPage(bm, h, 1));
+    sprintf(h->data, "%s", "stale");
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinNewPage(bm, h, &newPage));
+    ASSERT_EQUALS_INT(4, newPage, "new page past the end");
+    CHECK(unpinPage(bm, h));
+
+    // overwrite pages 1-3 and append 4-10 through a four page buffer
+    CHECK(beginBulkLoad(&bl, "testbuffer.bin", 1, 4, 0));
+    for (i = 0; i < 10; i++)
+    {
+        CHECK(nextBulkPage(&bl, h));
+        ASSERT_EQUALS_INT(1 + i, h->pageNum, "pages handed out in order");
+        sprintf(h->data, "%s-%i", "Bulk", h->pageNum);
+    }
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(4, fh.totalNumPages, "count not published before the end");
+    CHECK(closePageFile(&fh));
+
+    CHECK(finishBulkLoad(&bl, bm, BL_POOL_PREWARM));
+    ASSERT_EQUALS_INT(10, bl.numPages, "pages loaded");
+    ASSERT_EQUALS_POOL("[1 0],[2 0],[3 0],[4 0]", bm, "stale frames replaced by the loaded pages");
+    ASSERT_EQUALS_INT(0, getNumDirtyPages(bm), "dirty copies discarded");
+    CHECK(pinPage(bm, h, 1));
+    ASSERT_EQUALS_STRING("Bulk-1", h->data, "pool sees the loaded page");
+    ASSERT_TRUE(invalidatePages(bm, 0, 2) != RC_OK, "pinned pages are not invalidated");
+    CHECK(unpinPage(bm, h));
+    CHECK(pinNewPage(bm, h, &newPage));
+    ASSERT_EQUALS_INT(11, newPage, "new pages start after the loaded ones");
+    CHECK(unpinPage(bm, h));
+    CHECK(invalidatePages(bm, 11, 11));
+    ASSERT_EQUALS_INT(0, getNumDirtyPages(bm), "unwritten new page discarded");
+    CHECK(shutdownBufferPool(bm));
+
+    // a fresh open reads the header and the file size
+    closeIdleFiles();
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(11, fh.totalNumPages, "count written, over-reservation trimmed");
+    page = (char *) malloc(PAGE_SIZE);
+    CHECK(readBlock(10, &fh, page));
+    ASSERT_EQUALS_STRING("Bulk-10", page, "last loaded page");
+    CHECK(readBlock(0, &fh, page));
+    ASSERT_EQUALS_STRING("Page-0", page, "page before the load untouched");
+    free(page);
+    CHECK(closePageFile(&fh));
+
+    // an aborted load leaves the count alone
+    CHECK(beginBulkLoad(&bl, "testbuffer.bin", 11, 0, 100));
+    for (i = 0; i < 3; i++)
+        CHECK(nextBulkPage(&bl, h));
+    CHECK(abortBulkLoad(&bl));
+    closeIdleFiles();
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(11, fh.totalNumPages, "aborted pages discarded");
+    CHECK(closePageFile(&fh));
+    ASSERT_TRUE(beginBulkLoad(&bl, "testbuffer.bin", 12, 0, 0) != RC_OK, "no gap before the first page");
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// clean evicted pages are served from the L2 cache file, dirty ones never are
+void
+testL2Cache (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolStats stats;
+    int i;
+    testName = "Testing the L2 cache file";
+
+    createFilledPageFile("testbuffer.bin", 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+    CHECK(setL2Cache(bm, "testbuffer.l2", 16));
+
+    // pages 0-6 are evicted into L2
+    for (i = 0; i < 10; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(syncL2(bm));
+    CHECK(resetPoolStats(bm));
+
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        checkPageContent(h);
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(5, (int)stats.l2Hits, "loads served by L2");
+    ASSERT_EQUALS_INT(0, (int)stats.readIO, "no page file reads");
+
+    // a written page replaces its L2 copy
+    CHECK(pinPage(bm, h, 5));
+    sprintf(h->data, "%s", "changed");
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(syncL2(bm));
+    CHECK(pinPage(bm, h, 5));
+    ASSERT_EQUALS_STRING("changed", h->data, "L2 holds the written version");
+    CHECK(unpinPage(bm, h));
+
+    // dropping the tier loses nothing
+    CHECK(setL2Cache(bm, NULL, 0));
+    CHECK(resetPoolStats(bm));
+    for (i = 6; i < 10; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(pinPage(bm, h, 5));
+    ASSERT_EQUALS_STRING("changed", h->data, "page file has the written version");
+    CHECK(unpinPage(bm, h));
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(0, (int)stats.l2Hits, "no L2 once disabled");
+    ASSERT_TRUE(fopen("testbuffer.l2", "rb") == NULL, "cache file removed");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a scan confined to its partition cannot flush the other tenants' pages
+void
+testPartitions (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PartitionStats stats;
+    PageNumber frames[6];
+    int tenant, scan, other, i, resident;
+    testName = "Testing pool partitions";
+
+    createFilledPageFile("testbuffer.bin", 30);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 6, RS_LRU, NULL));
+    CHECK(createPartition(bm, "tenant", 2, 6, &tenant));
+    CHECK(createPartition(bm, "scan", 0, 2, &scan));
+    ASSERT_EQUALS_INT(scan, findPartition(bm, "scan"), "partition found by name");
+    ASSERT_EQUALS_INT(0, findPartition(bm, "default"), "default partition");
+    ASSERT_TRUE(createPartition(bm, "scan", 0, 1, &other) != RC_OK, "names are unique");
+    ASSERT_TRUE(createPartition(bm, "greedy", 5, 6, &other) != RC_OK, "minimums must fit the pool");
+
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPageInPartition(bm, h, i, tenant));
+        CHECK(unpinPage(bm, h));
+    }
+    for (i = 10; i < 30; i++)
+    {
+        CHECK(pinPageInPartition(bm, h, i, scan));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getFrameContentsInto(bm, frames));
+    for (i = 0, resident = 0; i < 6; i++)
+        if (frames[i] >= 0 && frames[i] < 4)
+            resident++;
+    ASSERT_EQUALS_INT(4, resident, "tenant pages survive the scan");
+    CHECK(getPartitionStats(bm, scan, &stats));
+    ASSERT_EQUALS_INT(2, (int)stats.frames, "scan held to its maximum");
+    ASSERT_EQUALS_INT(20, (int)stats.misses, "scan misses");
+    ASSERT_EQUALS_INT(18, (int)stats.evictions, "scan replaced its own pages");
+    CHECK(getPartitionStats(bm, tenant, &stats));
+    ASSERT_EQUALS_INT(4, (int)stats.frames, "tenant frames");
+    ASSERT_EQUALS_INT(0, (int)stats.evictions, "tenant lost nothing");
+
+    // a lowered maximum is reclaimed first, and never below the minimum
+    CHECK(setPartitionQuota(bm, tenant, 2, 3));
+    CHECK(pinPage(bm, h, 5));
+    CHECK(unpinPage(bm, h));
+    CHECK(getPartitionStats(bm, tenant, &stats));
+    ASSERT_EQUALS_INT(3, (int)stats.frames, "over-maximum partition gave up a frame");
+    for (i = 6; i < 10; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getPartitionStats(bm, tenant, &stats));
+    ASSERT_EQUALS_INT(2, (int)stats.frames, "minimum kept");
+    CHECK(getPartitionStats(bm, scan, &stats));
+    ASSERT_EQUALS_INT(0, (int)stats.frames, "scan has no minimum");
+    CHECK(getPartitionStats(bm, 0, &stats));
+    ASSERT_EQUALS_INT(4, (int)stats.frames, "default partition took the rest");
+    ASSERT_EQUALS_INT(5, (int)stats.misses, "default misses");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// high priority pins outlive normal pages, sticky pages are never evicted
+void
+testPriorityPins (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolStats stats;
+    PageNumber frames[4];
+    int i;
+    testName = "Testing priority pins and sticky pages";
+
+    createFilledPageFile("testbuffer.bin", 30);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_FIFO, NULL));
+    CHECK(pinPageWithPriority(bm, h, 0, BM_PRIORITY_HIGH));
+    CHECK(unpinPage(bm, h));
+    for (i = 1; i < 8; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[0 0],[7 0],[5 0],[6 0]", bm, "high priority page kept by FIFO");
+
+    // a low pin goes first even though FIFO would keep it longest
+    CHECK(pinPageWithPriority(bm, h, 8, BM_PRIORITY_LOW));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 9));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[0 0],[7 0],[9 0],[6 0]", bm, "low priority page evicted first");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_CLOCK, NULL));
+    CHECK(setPageResidency(bm, 20, BM_RESIDENCY_STICKY));
+    ASSERT_TRUE(setPageResidency(bm, 21, BM_RESIDENCY_STICKY) != RC_OK, "sticky limit of a quarter");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(1, (int)stats.stickyPages, "sticky pages in stats");
+    ASSERT_EQUALS_INT(1, (int)stats.stickyLimit, "sticky limit in stats");
+    for (i = 0; i < 12; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[20 0],[9 0],[10 0],[11 0]", bm, "sticky page survives a scan");
+
+    CHECK(setStickyFraction(bm, 0.5));
+    CHECK(setPageResidency(bm, 21, BM_RESIDENCY_STICKY));
+    CHECK(setPageResidency(bm, 20, BM_RESIDENCY_NORMAL));
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(1, (int)stats.stickyPages, "one page left sticky");
+    ASSERT_EQUALS_INT(2, (int)stats.stickyLimit, "raised limit");
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getFrameContentsInto(bm, frames));
+    for (i = 0; i < 4; i++)
+        ASSERT_TRUE(frames[i] != 20, "normal page evicted again");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+typedef struct PinWaitArgs {
+    BM_BufferPool *bm;
+    BM_PageHandle *page;
+    int seed;
+    int failures;
+} PinWaitArgs;
+
+// unpin a page after giving the main thread time to start waiting
+static void *
+unpinLater (void *arg)
+{
+    PinWaitArgs *args = (PinWaitArgs *) arg;
+    struct timespec delay = { 0, 50 * 1000000L };
+    nanosleep(&delay, NULL);
+    if (unpinPage(args->bm, args->page) != RC_OK)
+        args->failures++;
+    return NULL;
+}
+
+// pin and unpin pseudo-random pages, one pin held at a time
+static void *
+pinLoop (void *arg)
+{
+    PinWaitArgs *args = (PinWaitArgs *) arg;
+    BM_PageHandle h;
+    unsigned int x = args->seed;
+    int i;
+    for (i = 0; i < 2000; i++)
+    {
+        x = x * 1103515245u + 12345u;
+        if (pinPage(args->bm, &h, (x >> 8) % 12) != RC_OK)
+        {
+            args->failures++;
+            continue;
+        }
+        if ((x & 7) == 0)
+            markDirty(args->bm, &h);
+        if (unpinPage(args->bm, &h) != RC_OK)
+            args->failures++;
+    }
+    return NULL;
+}
+
+// pins wait for an unpin when every frame is pinned, up to a timeout
+void
+testPinWait (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle h0, h1;
+    BM_PoolStats stats;
+    PinWaitArgs args[4];
+    pthread_t threads[4];
+    int fixCounts[4];
+    long long waits;
+    RC rc;
+    int i;
+    testName = "Testing blocking pins";
+
+    createFilledPageFile("testbuffer.bin", 12);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_FIFO, NULL));
+    ASSERT_TRUE(setPinWaitTimeout(bm, 20) != RC_OK, "waiting needs concurrent mode");
+    CHECK(setConcurrentMode(bm, true));
+    CHECK(setPinWaitTimeout(bm, 20));
+
+    CHECK(pinPage(bm, &h0, 0));
+    CHECK(pinPage(bm, &h1, 1));
+    rc = pinPage(bm, h, 2);
+    ASSERT_EQUALS_INT(RC_PIN_TIMEOUT, rc, "wait timed out");
+
+    CHECK(setPinWaitTimeout(bm, 5000));
+    args[0].bm = bm;
+    args[0].page = &h0;
+    args[0].failures = 0;
+    pthread_create(&threads[0], NULL, unpinLater, &args[0]);
+    CHECK(pinPage(bm, h, 2));
+    pthread_join(threads[0], NULL);
+    ASSERT_EQUALS_INT(0, args[0].failures, "unpin from another thread");
+    ASSERT_EQUALS_POOL("[2 1],[1 1]", bm, "waiter got the unpinned frame");
+
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, (int)stats.pinWaits, "pins that waited");
+    ASSERT_EQUALS_INT(1, (int)stats.pinWaitTimeouts, "pins that timed out");
+    for (i = 0, waits = 0; i < BM_LATENCY_BUCKETS; i++)
+        waits += stats.pinWaitLatency[i];
+    ASSERT_EQUALS_INT(2, (int)waits, "wait durations recorded");
+    CHECK(unpinPage(bm, h));
+    CHECK(unpinPage(bm, &h1));
+    CHECK(shutdownBufferPool(bm));
+
+    // more threads than frames, none of them ever failing a pin
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+    CHECK(setConcurrentMode(bm, true));
+    CHECK(setPinWaitTimeout(bm, -1));
+    for (i = 0; i < 4; i++)
+    {
+        args[i].bm = bm;
+        args[i].seed = i + 1;
+        args[i].failures = 0;
+        pthread_create(&threads[i], NULL, pinLoop, &args[i]);
+    }
+    for (i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+        ASSERT_EQUALS_INT(0, args[i].failures, "no failed pins");
+    }
+    CHECK(getFixCountsInto(bm, fixCounts));
+    for (i = 0; i < 3; i++)
+        ASSERT_EQUALS_INT(0, fixCounts[i], "every pin released");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// sampled LRU keeps a hot set through a scan and still finds the last
+// unpinned frame when sampling misses it
+void
+testSampledEviction (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle pinned[16];
+    BM_PoolStats stats;
+    int i, round;
+    testName = "Testing sampled eviction";
+
+    createFilledPageFile("testbuffer.bin", 200);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 32, RS_SAMPLED_LRU, NULL));
+    ASSERT_TRUE(setSampleSize(bm, -1) != RC_OK, "negative sample size");
+    CHECK(setSampleSize(bm, 8));
+    for (round = 0; round < 20; round++)
+    {
+        for (i = 0; i < 8; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+        for (i = 0; i < 8; i++)
+        {
+            CHECK(pinPage(bm, h, 8 + (round * 8 + i) % 192));
+            CHECK(unpinPage(bm, h));
+        }
+    }
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_TRUE(stats.hits >= 19 * 8 - 8, "hot pages survive the scan");
+    CHECK(pinPage(bm, h, 3));
+    ASSERT_EQUALS_STRING("Page-3", h->data, "hashed lookup finds the page");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 16, RS_SAMPLED_LFU, NULL));
+    for (i = 0; i < 15; i++)
+        CHECK(pinPage(bm, &pinned[i], i));
+    CHECK(pinPage(bm, h, 15));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 100));
+    ASSERT_EQUALS_STRING("Page-100", h->data, "only unpinned frame reused");
+    CHECK(unpinPage(bm, h));
+    for (i = 0; i < 15; i++)
+        CHECK(unpinPage(bm, &pinned[i]));
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// one-hit pages are served from transient frames and leave the hot set alone
+void
+testAdmissionFilter (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolStats stats;
+    PageNumber frames[4];
+    int i, round, resident;
+    testName = "Testing TinyLFU admission";
+
+    createFilledPageFile("testbuffer.bin", 40);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+    CHECK(setAdmissionFilter(bm, true));
+    for (round = 0; round < 3; round++)
+        for (i = 0; i < 4; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+    for (i = 10; i < 30; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "Scan-%i", i);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0]", bm, "hot set survives the scan");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(20, (int)stats.admissionRejects, "scan pages rejected");
+
+    // a page that keeps coming back wins admission once it misses again
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(pinPage(bm, h, 35));
+        CHECK(unpinPage(bm, h));
+    }
+    for (i = 36; i < 40; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(pinPage(bm, h, 35));
+    ASSERT_EQUALS_STRING("Page-35", h->data, "frequent page read");
+    CHECK(unpinPage(bm, h));
+    CHECK(getFrameContentsInto(bm, frames));
+    for (i = 0, resident = 0; i < 4; i++)
+        if (frames[i] == 35)
+            resident++;
+    ASSERT_EQUALS_INT(1, resident, "frequent page admitted");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(25, (int)stats.admissionRejects, "rejects");
+
+    CHECK(pinPage(bm, h, 36));
+    ASSERT_TRUE(setAdmissionFilter(bm, false) != RC_OK, "transient page still pinned");
+    CHECK(unpinPage(bm, h));
+    CHECK(setAdmissionFilter(bm, false));
+    CHECK(shutdownBufferPool(bm));
+
+    // dirty transient pages reached the file
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+    CHECK(pinPage(bm, h, 29));
+    ASSERT_EQUALS_STRING("Scan-29", h->data, "transient page written back");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    // a rejected page leaves the victim it was weighed against untouched:
+    // no dirty fallback counted, and the CLOCK hand stays on it
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_CLOCK, NULL));
+    CHECK(setAdmissionFilter(bm, true));
+    CHECK(setEvictionWindow(bm, 2));
+    for (round = 0; round < 3; round++)
+        for (i = 0; i < 4; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            if (i < 2)
+                CHECK(markDirty(bm, h));
+            CHECK(unpinPage(bm, h));
+        }
+    for (i = 0; i < 8; i++)
+    {
+        CHECK(pinPage(bm, h, 20));
+        CHECK(unpinPage(bm, h));
+    }
+    for (i = 21; i < 25; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(5, (int)stats.admissionRejects, "one-off pages rejected");
+    ASSERT_EQUALS_INT(0, (int)stats.dirtyFallbacks, "no dirty fallback without an eviction");
+    ASSERT_EQUALS_POOL("[0x0],[1x0],[2 0],[3 0]", bm, "rejects evicted nothing");
+
+    CHECK(pinPage(bm, h, 20));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[20 0],[1x0],[2 0],[3 0]", bm, "admitted page takes the frame under the hand");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(1, (int)stats.dirtyFallbacks, "dirty fallback counted on the eviction");
+    CHECK(setAdmissionFilter(bm, false));
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// the estimated LRU miss ratio curve of a loop matches the real pool
+void
+testMissRatioCurve (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolStats stats;
+    double ratio;
+    RC rc;
+    int i, round;
+    testName = "Testing miss ratio curve estimation";
+
+    createFilledPageFile("testbuffer.bin", 40);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 10, RS_LRU, NULL));
+    rc = estimateMissRatio(bm, 10, &ratio);
+    ASSERT_TRUE(rc != RC_OK, "no estimate while tracking is off");
+
+    // every page sampled: a loop of 40 misses below 40 frames and only
+    // takes its cold misses above
+    CHECK(setMissRatioTracking(bm, 100));
+    for (round = 0; round < 10; round++)
+        for (i = 0; i < 40; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+    CHECK(getPoolStats(bm, &stats));
+    CHECK(estimateMissRatio(bm, 10, &ratio));
+    ASSERT_TRUE(ratio == (double)stats.misses / (stats.hits + stats.misses), "estimate matches the pool");
+    CHECK(estimateMissRatio(bm, 20, &ratio));
+    ASSERT_TRUE(ratio == 1.0, "loop larger than the pool");
+    CHECK(estimateMissRatio(bm, 64, &ratio));
+    ASSERT_TRUE(ratio > 0.099 && ratio < 0.101, "cold misses only");
+
+    // a small budget lowers the sampling rate but keeps the shape
+    CHECK(setMissRatioTracking(bm, 8));
+    for (round = 0; round < 10; round++)
+        for (i = 0; i < 40; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+    CHECK(estimateMissRatio(bm, 10, &ratio));
+    ASSERT_TRUE(ratio > 0.9, "sampled: small pools miss");
+    CHECK(estimateMissRatio(bm, 200, &ratio));
+    ASSERT_TRUE(ratio < 0.2, "sampled: large pools hit");
+
+    CHECK(setMissRatioTracking(bm, 0));
+    rc = estimateMissRatio(bm, 10, &ratio);
+    ASSERT_TRUE(rc != RC_OK, "tracking turned off");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// freed pages read as zeros, persist in the free map and are reused first
+void
+testFreePages (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    char *page = (char *) malloc(2 * PAGE_SIZE);
+    char *zeros = (char *) calloc(2 * PAGE_SIZE, 1);
+    PageNumber newPage;
+    int pageNum;
+    RC rc;
+    testName = "Testing freed pages";
+
+    createFilledPageFile("testbuffer.bin", 8);
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    CHECK(freePage(3, &fh));
+    CHECK(freePage(4, &fh));
+    CHECK(freePage(4, &fh));
+    ASSERT_EQUALS_INT(2, getNumFreePages(&fh), "two pages freed");
+    rc = freePage(8, &fh);
+    ASSERT_EQUALS_INT(RC_READ_NON_EXISTING_PAGE, rc, "page past the end");
+    CHECK(readBlock(3, &fh, page));
+    ASSERT_TRUE(memcmp(page, zeros, PAGE_SIZE) == 0, "freed page reads as zeros");
+    CHECK(readBlock(2, &fh, page));
+    ASSERT_EQUALS_STRING("Page-2", page, "neighbour below untouched");
+    CHECK(readBlock(5, &fh, page));
+    ASSERT_EQUALS_STRING("Page-5", page, "neighbour above untouched");
+    CHECK(closePageFile(&fh));
+    closeIdleFiles();
+
+    // the free map survives reopening; allocation reuses it before appending
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(2, getNumFreePages(&fh), "free map reloaded");
+    CHECK(readBlocks(3, 2, &fh, page));
+    ASSERT_TRUE(memcmp(page, zeros, 2 * PAGE_SIZE) == 0, "freed range reads as zeros");
+    CHECK(allocatePage(&pageNum, &fh));
+    ASSERT_EQUALS_INT(3, pageNum, "lowest freed page first");
+    CHECK(allocatePage(&pageNum, &fh));
+    ASSERT_EQUALS_INT(4, pageNum, "next freed page");
+    CHECK(allocatePage(&pageNum, &fh));
+    ASSERT_EQUALS_INT(8, pageNum, "appended when none is free");
+    ASSERT_EQUALS_INT(9, fh.totalNumPages, "file grew by one page");
+    CHECK(readBlock(8, &fh, page));
+    ASSERT_TRUE(memcmp(page, zeros, PAGE_SIZE) == 0, "appended page reads as zeros");
+
+    // writing a freed page takes it back
+    CHECK(freePage(6, &fh));
+    sprintf(page, "%s", "Rewritten-6");
+    CHECK(writeBlock(6, &fh, page));
+    ASSERT_EQUALS_INT(0, getNumFreePages(&fh), "write reallocated the page");
+    CHECK(readBlock(6, &fh, page));
+    ASSERT_EQUALS_STRING("Rewritten-6", page, "written page reads back");
+    CHECK(closePageFile(&fh));
+
+    // the pool drops its copy, and pinNewPage reuses the page
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    CHECK(pinPage(bm, h, 2));
+    rc = deallocatePage(bm, 2);
+    ASSERT_TRUE(rc != RC_OK, "pinned page cannot be freed");
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(deallocatePage(bm, 2));
+    ASSERT_EQUALS_POOL("[-1 0],[-1 0],[-1 0]", bm, "freed page left the pool");
+    CHECK(pinNewPage(bm, h, &newPage));
+    ASSERT_EQUALS_INT(2, newPage, "freed page handed out again");
+    ASSERT_TRUE(memcmp(h->data, zeros, PAGE_SIZE) == 0, "reused page is zeroed");
+    CHECK(unpinPage(bm, h));
+    CHECK(pinNewPage(bm, h, &newPage));
+    ASSERT_EQUALS_INT(9, newPage, "then the file grows");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    // freeing downwards widens the hole upwards, still only over free pages
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    sprintf(page, "%s", "Page-4");
+    CHECK(writeBlock(4, &fh, page));
+    CHECK(freePage(6, &fh));
+    CHECK(freePage(5, &fh));
+    CHECK(readBlock(4, &fh, page));
+    ASSERT_EQUALS_STRING("Page-4", page, "neighbour below untouched");
+    CHECK(readBlock(7, &fh, page));
+    ASSERT_EQUALS_STRING("Page-7", page, "neighbour above untouched");
+    CHECK(closePageFile(&fh));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    ASSERT_TRUE(access("testbuffer.bin.free", F_OK) != 0, "free map removed with the file");
+    free(bm);
+    free(h);
+    free(page);
+    free(zeros);
+    TEST_DONE();
+}
+
+// incremental backups copy only changed pages and restore to the same file
+void
+testIncrementalBackup (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh, copy;
+    char *page = (char *) malloc(PAGE_SIZE);
+    char *other = (char *) malloc(PAGE_SIZE);
+    struct stat st;
+    int i, same;
+    RC rc;
+    testName = "Testing incremental backups";
+
+    createFilledPageFile("testbuffer.bin", 40);
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(40, getNumChangedPages(&fh), "no base yet: every page");
+    CHECK(readBlock(7, &fh, page));
+    CHECK(backupPageFile(&fh, "testbackup.full", 1));
+    ASSERT_EQUALS_INT(0, getNumChangedPages(&fh), "first backup is the base");
+    ASSERT_EQUALS_INT(7, getBlockPos(&fh), "backup leaves the handle's position alone");
+
+    sprintf(page, "%s", "Changed-3");
+    CHECK(writeBlock(3, &fh, page));
+    CHECK(writeBlock(4, &fh, page));
+    CHECK(writeBlock(4, &fh, page));
+    CHECK(freePage(30, &fh));
+    CHECK(ensureCapacity(42, &fh));
+    CHECK(writeBlock(41, &fh, page));
+    ASSERT_EQUALS_INT(4, getNumChangedPages(&fh), "written and freed pages");
+    CHECK(closePageFile(&fh));
+    closeIdleFiles();
+
+    // the changed map survives reopening
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(4, getNumChangedPages(&fh), "changed map reloaded");
+    CHECK(backupPageFile(&fh, "testbackup.inc1", 1));
+    ASSERT_EQUALS_INT(0, getNumChangedPages(&fh), "epoch advanced");
+    CHECK(closePageFile(&fh));
+    ASSERT_TRUE(stat("testbackup.inc1", &st) == 0 && st.st_size < 4 * PAGE_SIZE, "only changed pages copied");
+
+    // online: dirty pages in the pool are flushed into the backup
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+    CHECK(pinPage(bm, h, 9));
+    sprintf(h->data, "%s", "Pooled-9");
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(backupPool(bm, "testbackup.inc2", true));
+    CHECK(shutdownBufferPool(bm));
+
+    // incrementals apply only in order, each once, on their own chain
+    CHECK(restoreBackup("testbackup.full", "testrestore.bin"));
+    rc = restoreBackup("testbackup.inc2", "testrestore.bin");
+    ASSERT_EQUALS_INT(RC_BACKUP_OUT_OF_ORDER, rc, "incremental applied out of order");
+    CHECK(restoreBackup("testbackup.inc1", "testrestore.bin"));
+    rc = restoreBackup("testbackup.inc1", "testrestore.bin");
+    ASSERT_EQUALS_INT(RC_BACKUP_OUT_OF_ORDER, rc, "incremental applied twice");
+    CHECK(restoreBackup("testbackup.inc2", "testrestore.bin"));
+    rc = restoreBackup("testbackup.inc1", "testother.bin");
+    ASSERT_EQUALS_INT(RC_BACKUP_OUT_OF_ORDER, rc, "incremental without its full backup");
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    CHECK(openPageFile("testrestore.bin", &copy));
+    ASSERT_EQUALS_INT(fh.totalNumPages, copy.totalNumPages, "restored page count");
+    for (i = 0, same = 0; i < fh.totalNumPages; i++)
+    {
+        CHECK(readBlock(i, &fh, page));
+        CHECK(readBlock(i, &copy, other));
+        same += memcmp(page, other, PAGE_SIZE) == 0;
+    }
+    ASSERT_EQUALS_INT(fh.totalNumPages, same, "every page restored");
+    CHECK(readBlock(9, &copy, page));
+    ASSERT_EQUALS_STRING("Pooled-9", page, "pool page in the online backup");
+    CHECK(closePageFile(&fh));
+    CHECK(closePageFile(&copy));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    CHECK(destroyPageFile("testrestore.bin"));
+    ASSERT_TRUE(access("testbuffer.bin.changed", F_OK) != 0, "changed map removed with the file");
+    ASSERT_TRUE(access("testrestore.bin.restored", F_OK) != 0, "restored epoch removed with the file");
+    ASSERT_TRUE(access("testother.bin", F_OK) != 0, "refused restore created nothing");
+    remove("testbackup.full");
+    remove("testbackup.inc1");
+    remove("testbackup.inc2");
+    free(bm);
+    free(h);
+    free(page);
+    free(other);
+    TEST_DONE();
+}
+
+// prewarm, invalidate and mark pages sticky past the pinned range
+static void *
+maintenanceLoop (void *arg)
+{
+    PinWaitArgs *args = (PinWaitArgs *) arg;
+    BM_PoolStats stats;
+    PageNumber contents[8];
+    int i;
+    for (i = 0; i < 300; i++)
+    {
+        PageNumber sticky = 12 + i % 4;
+        if (prewarm(args->bm, 12, 15) != RC_OK)
+            args->failures++;
+        if (setPageResidency(args->bm, sticky, BM_RESIDENCY_STICKY) != RC_OK)
+            args->failures++;
+        if (getPoolStats(args->bm, &stats) != RC_OK || stats.stickyPages != 1)
+            args->failures++;
+        if (getFrameContentsInto(args->bm, contents) != RC_OK)
+            args->failures++;
+        if (setPageResidency(args->bm, sticky, BM_RESIDENCY_NORMAL) != RC_OK)
+            args->failures++;
+        if (invalidatePages(args->bm, 12, 15) != RC_OK)
+            args->failures++;
+    }
+    return NULL;
+}
+
+// maintenance calls take the pool lock alongside concurrent pins
+void
+testConcurrentMaintenance (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolStats stats;
+    PinWaitArgs args[4];
+    pthread_t threads[4];
+    int fixCounts[8];
+    int i;
+    testName = "Testing maintenance calls under concurrent pins";
+
+    createFilledPageFile("testbuffer.bin", 16);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_LRU, NULL));
+    CHECK(setStickyFraction(bm, 0.25));
+    CHECK(setConcurrentMode(bm, true));
+    CHECK(setPinWaitTimeout(bm, -1));
+    for (i = 0; i < 4; i++)
+    {
+        args[i].bm = bm;
+        args[i].seed = i + 1;
+        args[i].failures = 0;
+        pthread_create(&threads[i], NULL, i == 0 ? maintenanceLoop : pinLoop, &args[i]);
+    }
+    for (i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+        ASSERT_EQUALS_INT(0, args[i].failures, "no failed calls");
+    }
+
+    CHECK(getFixCountsInto(bm, fixCounts));
+    for (i = 0; i < 8; i++)
+        ASSERT_EQUALS_INT(0, fixCounts[i], "every pin released");
+    CHECK(getPoolStats(bm, &stats));
+    ASSERT_EQUALS_INT(0, (int) stats.stickyPages, "no page left sticky");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    TEST_DONE();
+}
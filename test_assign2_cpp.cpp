@@ -0,0 +1,154 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.hpp"
+#include "dberror.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+
+// var to store the current test's name
+char *testName;
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected,bm,message)                    \
+do {                                    \
+char *real;                                \
+const char *_exp = (expected);                                   \
+real = sprintPoolContent(bm);                    \
+if (strcmp((_exp),real) != 0)                    \
+{                                    \
+printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+free(real);                            \
+exit(1);                            \
+}                                    \
+printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+free(real);                                \
+} while(0)
+
+struct Row {
+    int id;
+    char name[28];
+};
+
+// test and helper methods
+static void createFilledPageFile (const char *fileName, int num);
+static void testPageGuard (void);
+static void testPageView (void);
+
+// main method
+int
+main (void)
+{
+    initStorageManager();
+    testName = (char *) "";
+
+    testPageGuard();
+    testPageView();
+    return 0;
+}
+
+// create a page file with num pages whose content is "Page-X"
+void
+createFilledPageFile(const char *fileName, int num)
+{
+    SM_FileHandle fh;
+    char *page = (char *) calloc(PAGE_SIZE, sizeof(char));
+    int i;
+
+    CHECK(createPageFile((char *) fileName));
+    CHECK(openPageFile((char *) fileName, &fh));
+    CHECK(ensureCapacity(num, &fh));
+    for (i = 0; i < num; i++)
+    {
+        sprintf(page, "%s-%i", "Page", i);
+        CHECK(writeBlock(i, &fh, page));
+    }
+    CHECK(closePageFile(&fh));
+    free(page);
+}
+
+// guards unpin when they go out of scope, and moves transfer the pin
+void
+testPageGuard (void)
+{
+    testName = (char *) "Testing PageGuard";
+
+    createFilledPageFile("testbuffer.bin", 5);
+    {
+        bm::BufferPool pool("testbuffer.bin", 3, RS_FIFO);
+        TEST_CHECK(pool.status());
+
+        {
+            bm::PageGuard g0 = pool.pin(0);
+            bm::PageGuard g1 = pool.pin(1);
+            TEST_CHECK(g0.status());
+            ASSERT_EQUALS_STRING("Page-1", g1.data(), "pinned page content");
+            ASSERT_EQUALS_POOL("[0 1],[1 1],[-1 0]", pool.get(), "two pins held");
+        }
+        ASSERT_EQUALS_POOL("[0 0],[1 0],[-1 0]", pool.get(), "unpinned at scope exit");
+
+        bm::PageGuard moved;
+        {
+            bm::PageGuard g2 = pool.pin(2);
+            moved = std::move(g2);
+            ASSERT_TRUE(!g2, "moved-from guard is empty");
+        }
+        ASSERT_EQUALS_POOL("[0 0],[1 0],[2 1]", pool.get(), "pin survives the move");
+        moved = pool.pin(0);
+        ASSERT_EQUALS_POOL("[0 1],[1 0],[2 0]", pool.get(), "assignment unpins the old page");
+        TEST_CHECK(moved.unpin());
+        ASSERT_TRUE(!moved, "explicit unpin empties the guard");
+
+        bm::PageGuard bad = pool.pin(-1);
+        ASSERT_TRUE(!bad && bad.status() != RC_OK, "failed pin reports its error");
+
+        bm::PageGuard fresh = pool.pinNew();
+        TEST_CHECK(fresh.status());
+        ASSERT_EQUALS_INT(5, fresh.pageNum(), "new page past the end");
+        sprintf(fresh.data(), "%s", "fresh");
+    }
+
+    // the pool shut down after the last guard, flushing the new page
+    SM_FileHandle fh;
+    char *page = (char *) malloc(PAGE_SIZE);
+    TEST_CHECK(openPageFile((char *) "testbuffer.bin", &fh));
+    TEST_CHECK(readBlock(5, &fh, page));
+    ASSERT_EQUALS_STRING("fresh", page, "new page written at shutdown");
+    TEST_CHECK(closePageFile(&fh));
+    free(page);
+
+    TEST_CHECK(destroyPageFile((char *) "testbuffer.bin"));
+    TEST_DONE();
+}
+
+// typed views write through to the frame
+void
+testPageView (void)
+{
+    testName = (char *) "Testing PageView";
+
+    createFilledPageFile("testbuffer.bin", 2);
+    {
+        bm::BufferPool pool("testbuffer.bin", 2, RS_LRU);
+        bm::PageGuard guard = pool.pin(1);
+        bm::PageView<Row> row(guard);
+        row->id = 42;
+        strcpy(row->name, "answer");
+        TEST_CHECK(row.markDirty());
+    }
+    {
+        bm::BufferPool pool("testbuffer.bin", 2, RS_LRU);
+        bm::PageGuard guard = pool.pin(1);
+        bm::PageView<Row> row(guard);
+        ASSERT_EQUALS_INT(42, row->id, "field read back from disk");
+        ASSERT_EQUALS_STRING("answer", (*row).name, "struct read back from disk");
+    }
+
+    static_assert(sizeof(bm::PageGuard) <= 4 * sizeof(void *), "guard holds the C handle and nothing else");
+    TEST_CHECK(destroyPageFile((char *) "testbuffer.bin"));
+    TEST_DONE();
+}
@@ -0,0 +1,241 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "event_trace.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// built with -DBM_EVENT_TRACE (see the Makefile), so the tracepoints in the
+// buffer and storage managers record into the per-thread rings
+
+// var to store the current test's name
+char *testName;
+
+#define TRACE_FILE "testtrace.bin"
+
+typedef struct DumpedTrace {
+    int numRings;
+    int numEvents;
+    int threadIds[ET_MAX_THREADS];
+    ET_Event *events;
+} DumpedTrace;
+
+// test and helper methods
+static void createFilledPageFile(char *fileName, int num);
+static void readTrace(const char *fileName, DumpedTrace *trace);
+static int countEvents(DumpedTrace *trace, int type);
+
+static void testTraceDump (void);
+static void testRingRecycling (void);
+static void testRingLimit (void);
+
+// main method
+int
+main (void)
+{
+    initStorageManager();
+    testName = "";
+
+    testTraceDump();
+    testRingRecycling();
+    testRingLimit();
+    return 0;
+}
+
+// create a page file with num pages whose content is "Page-X"
+void
+createFilledPageFile(char *fileName, int num)
+{
+    SM_FileHandle fh;
+    char *page = (char *) calloc(PAGE_SIZE, sizeof(char));
+    int i;
+
+    TEST_CHECK(createPageFile(fileName));
+    TEST_CHECK(openPageFile(fileName, &fh));
+    TEST_CHECK(ensureCapacity(num, &fh));
+    for (i = 0; i < num; i++)
+    {
+        sprintf(page, "%s-%i", "Page", i);
+        TEST_CHECK(writeBlock(i, &fh, page));
+    }
+    TEST_CHECK(closePageFile(&fh));
+    free(page);
+}
+
+// decode a dumpEventTrace file the same way trace_decode does
+void
+readTrace(const char *fileName, DumpedTrace *trace)
+{
+    char magic[4];
+    int version, r;
+    double ticksPerUs;
+    FILE *fp = fopen(fileName, "rb");
+
+    ASSERT_TRUE(fp != NULL, "trace file exists");
+    ASSERT_TRUE(fread(magic, 1, 4, fp) == 4 && memcmp(magic, ET_MAGIC, 4) == 0, "trace starts with the magic");
+    ASSERT_TRUE(fread(&version, sizeof(int), 1, fp) == 1 && version == ET_VERSION, "trace has the current version");
+    ASSERT_TRUE(fread(&ticksPerUs, sizeof(double), 1, fp) == 1 && ticksPerUs > 0, "trace has a clock rate");
+    ASSERT_TRUE(fread(&trace->numRings, sizeof(int), 1, fp) == 1, "trace has a ring count");
+    ASSERT_TRUE(trace->numRings > 0 && trace->numRings <= ET_MAX_THREADS, "ring count within the limit");
+
+    trace->numEvents = 0;
+    trace->events = NULL;
+    for (r = 0; r < trace->numRings; r++)
+    {
+        int n;
+        ASSERT_TRUE(fread(&trace->threadIds[r], sizeof(int), 1, fp) == 1 && fread(&n, sizeof(int), 1, fp) == 1,
+                    "ring header is complete");
+        trace->events = (ET_Event *) realloc(trace->events, sizeof(ET_Event) * (trace->numEvents + n + 1));
+        ASSERT_TRUE(fread(trace->events + trace->numEvents, sizeof(ET_Event), n, fp) == (size_t) n,
+                    "ring events are complete");
+        trace->numEvents += n;
+    }
+    ASSERT_TRUE(fgetc(fp) == EOF, "no bytes after the last ring");
+    fclose(fp);
+}
+
+// count the decoded events of one type
+int
+countEvents(DumpedTrace *trace, int type)
+{
+    int i, count = 0;
+    for (i = 0; i < trace->numEvents; i++)
+        if (trace->events[i].type == type)
+            count++;
+    return count;
+}
+
+// pin pages through a small pool, dump the trace and decode it
+void
+testTraceDump (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    DumpedTrace trace;
+    int i, pins = 0, inOrder = 1, rc;
+
+    testName = "Dumping and decoding the event trace";
+
+    createFilledPageFile("testbuffer.bin", 10);
+    TEST_CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    resetEventTrace();
+
+    for (i = 0; i < 10; i++)
+    {
+        TEST_CHECK(pinPage(bm, h, i));
+        if (i == 0)
+            TEST_CHECK(markDirty(bm, h));
+        TEST_CHECK(unpinPage(bm, h));
+    }
+    TEST_CHECK(shutdownBufferPool(bm));
+    TEST_CHECK(dumpEventTrace(TRACE_FILE));
+
+    readTrace(TRACE_FILE, &trace);
+    for (i = 0; i < trace.numEvents; i++)
+        if (trace.events[i].type == ET_PIN_PAGE)
+            inOrder &= (trace.events[i].pageNum == pins++);
+    ASSERT_EQUALS_INT(10, pins, "one pinPage event per pin");
+    ASSERT_TRUE(inOrder, "pinPage events carry the pinned pages in order");
+    ASSERT_TRUE(countEvents(&trace, ET_READ_BLOCK) > 0, "misses read from disk");
+    ASSERT_TRUE(countEvents(&trace, ET_SELECT_VICTIM) >= 7, "misses on a full pool choose a victim");
+    ASSERT_TRUE(countEvents(&trace, ET_WRITE_FRAME) >= 1, "the dirty page is written back");
+    ASSERT_EQUALS_INT(0, (int) getEventTraceDropped(), "no events dropped");
+    free(trace.events);
+
+    rc = system("./trace_decode -s " TRACE_FILE " > /dev/null");
+    ASSERT_EQUALS_INT(0, rc, "trace_decode accepts the dump");
+
+    TEST_CHECK(destroyPageFile("testbuffer.bin"));
+    remove(TRACE_FILE);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+static void *
+recordOneEvent (void *arg)
+{
+    ET_BEGIN(start);
+    ET_END(ET_PIN_PAGE, (int) (long) arg, -1, start);
+    return NULL;
+}
+
+// threads that have exited give their rings to later threads
+void
+testRingRecycling (void)
+{
+    DumpedTrace trace;
+    int i, lastSeen = 0;
+
+    testName = "Recycling the rings of exited threads";
+
+    resetEventTrace();
+    for (i = 0; i < 2 * ET_MAX_THREADS; i++)
+    {
+        pthread_t thread;
+        pthread_create(&thread, NULL, recordOneEvent, (void *) (long) i);
+        pthread_join(thread, NULL);
+    }
+    ASSERT_EQUALS_INT(0, (int) getEventTraceDropped(), "no events dropped past ET_MAX_THREADS threads");
+
+    TEST_CHECK(dumpEventTrace(TRACE_FILE));
+    readTrace(TRACE_FILE, &trace);
+    for (i = 0; i < trace.numEvents; i++)
+        if (trace.events[i].pageNum == 2 * ET_MAX_THREADS - 1)
+            lastSeen = 1;
+    ASSERT_TRUE(lastSeen, "the last thread's event is in the dump");
+    free(trace.events);
+
+    remove(TRACE_FILE);
+    TEST_DONE();
+}
+
+static pthread_barrier_t limitBarrier;
+
+static void *
+recordAndHold (void *arg)
+{
+    recordOneEvent(arg);
+    pthread_barrier_wait(&limitBarrier);    // everyone has recorded
+    pthread_barrier_wait(&limitBarrier);    // main has checked the count
+    return NULL;
+}
+
+// more live threads than rings: the extra events are counted as dropped
+void
+testRingLimit (void)
+{
+    pthread_t threads[ET_MAX_THREADS];
+    pthread_t late;
+    long i;
+    int dropped;
+
+    testName = "Reporting events dropped past the ring limit";
+
+    resetEventTrace();
+    recordOneEvent((void *) -1L);   // main keeps a ring throughout
+    pthread_barrier_init(&limitBarrier, NULL, ET_MAX_THREADS + 1);
+    for (i = 0; i < ET_MAX_THREADS; i++)
+        pthread_create(&threads[i], NULL, recordAndHold, (void *) i);
+
+    pthread_barrier_wait(&limitBarrier);
+    dropped = (int) getEventTraceDropped();
+    ASSERT_EQUALS_INT(1, dropped, "the thread without a ring is reported");
+    pthread_barrier_wait(&limitBarrier);
+    for (i = 0; i < ET_MAX_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    pthread_barrier_destroy(&limitBarrier);
+
+    pthread_create(&late, NULL, recordOneEvent, (void *) 0L);
+    pthread_join(late, NULL);
+    dropped = (int) getEventTraceDropped();
+    ASSERT_EQUALS_INT(1, dropped, "threads get rings again once others exit");
+
+    TEST_DONE();
+}
@@ -0,0 +1,115 @@
+/************************************************************
+ * Event trace decoder
+ *
+ * Prints the events of a dumpEventTrace file in time order,
+ * followed by a per-event-type latency summary.
+ *
+ * usage: trace_decode [-s] traceFile   (-s: summary only)
+ ************************************************************/
+#include "event_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct DecodedEvent {
+    ET_Event event;
+    int threadId;
+} DecodedEvent;
+
+static const char *eventNames[] = {
+    "?", "pinPage", "selectVictimFrame", "writeFrameToDisk", "readBlock", "writeBlock"
+};
+#define NUM_EVENT_TYPES ((int)(sizeof(eventNames) / sizeof(eventNames[0])))
+
+static int compareEvents(const void *a, const void *b) {
+    unsigned long long x = ((const DecodedEvent *)a)->event.timestamp;
+    unsigned long long y = ((const DecodedEvent *)b)->event.timestamp;
+    return (x > y) - (x < y);
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static const char *eventName(int type) {
+    return (type > 0 && type < NUM_EVENT_TYPES) ? eventNames[type] : eventNames[0];
+}
+
+int main(int argc, char **argv) {
+    char magic[4];
+    int version, numRings, total = 0, capacity = 1024;
+    double ticksPerUs;
+    int summaryOnly = 0;
+    const char *fileName = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) summaryOnly = 1;
+        else fileName = argv[i];
+    }
+    if (!fileName) {
+        fprintf(stderr, "usage: %s [-s] traceFile\n", argv[0]);
+        return 2;
+    }
+
+    FILE *fp = fopen(fileName, "rb");
+    if (!fp || fread(magic, 1, 4, fp) != 4 || memcmp(magic, ET_MAGIC, 4) != 0 ||
+        fread(&version, sizeof(int), 1, fp) != 1 || version != ET_VERSION ||
+        fread(&ticksPerUs, sizeof(double), 1, fp) != 1 ||
+        fread(&numRings, sizeof(int), 1, fp) != 1) {
+        fprintf(stderr, "%s: not an event trace\n", fileName);
+        return 1;
+    }
+
+    DecodedEvent *events = (DecodedEvent *)malloc(sizeof(DecodedEvent) * capacity);
+    for (int r = 0; r < numRings; r++) {
+        int threadId, n;
+        if (fread(&threadId, sizeof(int), 1, fp) != 1 || fread(&n, sizeof(int), 1, fp) != 1) break;
+        for (int i = 0; i < n; i++) {
+            if (total == capacity) {
+                capacity *= 2;
+                events = (DecodedEvent *)realloc(events, sizeof(DecodedEvent) * capacity);
+            }
+            if (fread(&events[total].event, sizeof(ET_Event), 1, fp) != 1) break;
+            events[total++].threadId = threadId;
+        }
+    }
+    fclose(fp);
+
+    qsort(events, total, sizeof(DecodedEvent), compareEvents);
+    unsigned long long origin = total ? events[0].event.timestamp : 0;
+    double nsPerTick = 1000.0 / ticksPerUs;
+
+    if (!summaryOnly) {
+        printf("%14s %6s %-18s %8s %6s %12s\n", "time_us", "thread", "event", "page", "frame", "duration_ns");
+        for (int i = 0; i < total; i++) {
+            const ET_Event *e = &events[i].event;
+            printf("%14.3f %6d %-18s %8d %6d %12.0f\n",
+                   (e->timestamp - origin) / ticksPerUs, events[i].threadId, eventName(e->type),
+                   e->pageNum, e->frame, e->duration * nsPerTick);
+        }
+        printf("\n");
+    }
+
+    // per-type summary
+    double *durations = (double *)malloc(sizeof(double) * (total ? total : 1));
+    printf("%-18s %8s %10s %10s %10s %10s\n", "event", "count", "avg_ns", "p50_ns", "p99_ns", "max_ns");
+    for (int type = 1; type < NUM_EVENT_TYPES; type++) {
+        int n = 0;
+        double sum = 0;
+        for (int i = 0; i < total; i++)
+            if (events[i].event.type == type) {
+                durations[n] = events[i].event.duration * nsPerTick;
+                sum += durations[n++];
+            }
+        if (n == 0) continue;
+        qsort(durations, n, sizeof(double), compareDoubles);
+        printf("%-18s %8d %10.0f %10.0f %10.0f %10.0f\n", eventNames[type], n, sum / n,
+               durations[n / 2], durations[(int)(0.99 * (n - 1))], durations[n - 1]);
+    }
+
+    free(durations);
+    free(events);
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include "victim_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Token format of the page codec (byte oriented LZ77):
+//   0x00-0x7F  literal run of (c + 1) bytes that follow
+//   0x80-0xFF  match of ((c & 0x7F) + MIN_MATCH) bytes, 2-byte little endian offset follows
+#define MIN_MATCH 3
+#define MAX_MATCH (0x7F + MIN_MATCH)
+#define MAX_LITERALS 0x80
+#define MAX_OFFSET 0xFFFF
+#define CODEC_HASH_BITS 12
+
+typedef struct VC_Entry {
+    PageNumber pageNum;
+    int size;                   // stored bytes; == pageSize means stored raw
+    struct VC_Entry *hashNext;
+    struct VC_Entry *prev;      // LRU list, head is the oldest entry
+    struct VC_Entry *next;
+    unsigned char data[];
+} VC_Entry;
+
+struct VC_Cache {
+    size_t budget;
+    size_t used;
+    int pageSize;
+    int numEntries;
+    int numBuckets;
+    VC_Entry **buckets;
+    VC_Entry *oldest;
+    VC_Entry *newest;
+    unsigned char *scratch;     // compression output buffer
+};
+
+// Helper: hash of the next MIN_MATCH bytes
+static unsigned hash3(const unsigned char *p) {
+    unsigned v = ((unsigned)p[0] << 16) | ((unsigned)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - CODEC_HASH_BITS);
+}
+
+// Helper: emit pending literals as runs of at most MAX_LITERALS bytes
+static bool emitLiterals(const unsigned char *lit, int n, unsigned char *out, int *op, int cap) {
+    while (n > 0) {
+        int run = (n > MAX_LITERALS) ? MAX_LITERALS : n;
+        if (*op + 1 + run > cap) return false;
+        out[(*op)++] = (unsigned char)(run - 1);
+        memcpy(out + *op, lit, run);
+        *op += run;
+        lit += run;
+        n -= run;
+    }
+    return true;
+}
+
+// Helper: compress a page; returns 0 when the result would not be smaller than cap
+static int compressPage(const unsigned char *in, int len, unsigned char *out, int cap) {
+    int table[1 << CODEC_HASH_BITS];
+    int ip = 0, op = 0, litStart = 0;
+
+    for (int i = 0; i < (1 << CODEC_HASH_BITS); i++) table[i] = -1;
+
+    while (ip + MIN_MATCH <= len) {
+        unsigned h = hash3(in + ip);
+        int ref = table[h];
+        table[h] = ip;
+        if (ref >= 0 && ip - ref <= MAX_OFFSET && memcmp(in + ref, in + ip, MIN_MATCH) == 0) {
+            int max = (len - ip < MAX_MATCH) ? len - ip : MAX_MATCH;
+            int mlen = MIN_MATCH;
+            while (mlen < max && in[ref + mlen] == in[ip + mlen]) mlen++;
+
+            if (!emitLiterals(in + litStart, ip - litStart, out, &op, cap)) return 0;
+            if (op + 3 > cap) return 0;
+            out[op++] = (unsigned char)(0x80 | (mlen - MIN_MATCH));
+            out[op++] = (unsigned char)((ip - ref) & 0xFF);
+            out[op++] = (unsigned char)((ip - ref) >> 8);
+            ip += mlen;
+            litStart = ip;
+        } else {
+            ip++;
+        }
+    }
+    if (!emitLiterals(in + litStart, len - litStart, out, &op, cap)) return 0;
+    return op;
+}
+
+// Helper: decompress into out; returns false on malformed input
+static bool decompressPage(const unsigned char *in, int len, unsigned char *out, int outLen) {
+    int ip = 0, op = 0;
+
+    while (ip < len) {
+        int c = in[ip++];
+        if (c < 0x80) {
+            int n = c + 1;
+            if (ip + n > len || op + n > outLen) return false;
+            memcpy(out + op, in + ip, n);
+            ip += n;
+            op += n;
+        } else {
+            int n = (c & 0x7F) + MIN_MATCH;
+            if (ip + 2 > len) return false;
+            int off = in[ip] | (in[ip + 1] << 8);
+            ip += 2;
+            if (off == 0 || off > op || op + n > outLen) return false;
+            // byte-wise copy so overlapping matches replicate runs
+            for (int i = 0; i < n; i++, op++) out[op] = out[op - off];
+        }
+    }
+    return op == outLen;
+}
+
+// Helper: bucket of a page number
+static VC_Entry **bucketOf(VC_Cache *vc, PageNumber pageNum) {
+    return &vc->buckets[((unsigned)pageNum * 2654435761u) & (unsigned)(vc->numBuckets - 1)];
+}
+
+// Helper: bytes charged against the budget for an entry
+static size_t entryCost(int size) {
+    return sizeof(VC_Entry) + (size_t)size;
+}
+
+// Helper: unlink an entry from hash chain and LRU list and free it
+static void removeEntry(VC_Cache *vc, VC_Entry *e) {
+    VC_Entry **link = bucketOf(vc, e->pageNum);
+    while (*link != e) link = &(*link)->hashNext;
+    *link = e->hashNext;
+
+    if (e->prev) e->prev->next = e->next; else vc->oldest = e->next;
+    if (e->next) e->next->prev = e->prev; else vc->newest = e->prev;
+
+    vc->used -= entryCost(e->size);
+    vc->numEntries--;
+    free(e);
+}
+
+// Helper: find the entry of a page
+static VC_Entry *lookupEntry(VC_Cache *vc, PageNumber pageNum) {
+    for (VC_Entry *e = *bucketOf(vc, pageNum); e; e = e->hashNext)
+        if (e->pageNum == pageNum) return e;
+    return NULL;
+}
+
+VC_Cache *createVictimCache(size_t budgetBytes, int pageSize) {
+    VC_Cache *vc = (VC_Cache *)calloc(1, sizeof(VC_Cache));
+    if (!vc) return NULL;
+
+    // size the table for pages compressing to roughly a quarter page
+    size_t expected = budgetBytes / (sizeof(VC_Entry) + pageSize / 4) + 1;
+    vc->numBuckets = 64;
+    while ((size_t)vc->numBuckets < expected) vc->numBuckets <<= 1;
+
+    vc->budget = budgetBytes;
+    vc->pageSize = pageSize;
+    vc->buckets = (VC_Entry **)calloc(vc->numBuckets, sizeof(VC_Entry *));
+    vc->scratch = (unsigned char *)malloc(pageSize);
+    if (!vc->buckets || !vc->scratch) {
+        destroyVictimCache(vc);
+        return NULL;
+    }
+    vc->used = sizeof(VC_Cache) + sizeof(VC_Entry *) * vc->numBuckets;
+    return vc;
+}
+
+void destroyVictimCache(VC_Cache *vc) {
+    if (!vc) return;
+    VC_Entry *e = vc->oldest;
+    while (e) {
+        VC_Entry *next = e->next;
+        free(e);
+        e = next;
+    }
+    free(vc->buckets);
+    free(vc->scratch);
+    free(vc);
+}
+
+void putVictimPage(VC_Cache *vc, PageNumber pageNum, const char *data) {
+    if (!vc || pageNum < 0) return;
+
+    VC_Entry *old = lookupEntry(vc, pageNum);
+    if (old) removeEntry(vc, old);
+
+    int size = compressPage((const unsigned char *)data, vc->pageSize, vc->scratch, vc->pageSize - 1);
+    const unsigned char *src = vc->scratch;
+    if (size == 0) {
+        size = vc->pageSize;
+        src = (const unsigned char *)data;
+    }
+
+    if (vc->used + entryCost(size) > vc->budget) {
+        // make room by dropping the oldest entries
+        while (vc->oldest && vc->used + entryCost(size) > vc->budget)
+            removeEntry(vc, vc->oldest);
+        if (vc->used + entryCost(size) > vc->budget) return;
+    }
+
+    VC_Entry *e = (VC_Entry *)malloc(sizeof(VC_Entry) + size);
+    if (!e) return;
+    e->pageNum = pageNum;
+    e->size = size;
+    memcpy(e->data, src, size);
+
+    VC_Entry **bucket = bucketOf(vc, pageNum);
+    e->hashNext = *bucket;
+    *bucket = e;
+
+    e->next = NULL;
+    e->prev = vc->newest;
+    if (vc->newest) vc->newest->next = e; else vc->oldest = e;
+    vc->newest = e;
+
+    vc->used += entryCost(size);
+    vc->numEntries++;
+}
+
+bool takeVictimPage(VC_Cache *vc, PageNumber pageNum, char *data) {
+    if (!vc) return false;
+    VC_Entry *e = lookupEntry(vc, pageNum);
+    if (!e) return false;
+
+    bool ok = true;
+    if (e->size == vc->pageSize)
+        memcpy(data, e->data, vc->pageSize);
+    else
+        ok = decompressPage(e->data, e->size, (unsigned char *)data, vc->pageSize);
+
+    // the pool now owns the page, so the cached copy would only go stale
+    removeEntry(vc, e);
+    return ok;
+}
+
+void dropVictimPage(VC_Cache *vc, PageNumber pageNum) {
+    if (!vc) return;
+    VC_Entry *e = lookupEntry(vc, pageNum);
+    if (e) removeEntry(vc, e);
+}
+
+void dropVictimRange(VC_Cache *vc, PageNumber firstPage, PageNumber lastPage) {
+    if (!vc) return;
+    // one pass over the entries, the range may be far larger than the cache
+    VC_Entry *e = vc->oldest;
+    while (e) {
+        VC_Entry *next = e->next;
+        if (e->pageNum >= firstPage && e->pageNum <= lastPage) removeEntry(vc, e);
+        e = next;
+    }
+}
+
+int getVictimCacheEntries(VC_Cache *vc) {
+    return vc ? vc->numEntries : 0;
+}
+
+size_t getVictimCacheBytes(VC_Cache *vc) {
+    return vc ? vc->used : 0;
+}
@@ -0,0 +1,27 @@
+#ifndef VICTIM_CACHE_H
+#define VICTIM_CACHE_H
+
+#include "buffer_mgr.h"
+#include <stddef.h>
+
+// Compressed second-tier cache for pages evicted from a buffer pool.
+// Entries are compressed copies of clean pages; the total footprint
+// (entries plus bookkeeping) never exceeds the configured budget.
+typedef struct VC_Cache VC_Cache;
+
+VC_Cache *createVictimCache (size_t budgetBytes, int pageSize);
+void destroyVictimCache (VC_Cache *vc);
+
+// store a copy of a clean page, replacing any older copy
+void putVictimPage (VC_Cache *vc, PageNumber pageNum, const char *data);
+// decompress a page into data and drop it from the cache; false on miss
+bool takeVictimPage (VC_Cache *vc, PageNumber pageNum, char *data);
+// drop a cached copy, if any
+void dropVictimPage (VC_Cache *vc, PageNumber pageNum);
+// drop the cached copies of pages firstPage..lastPage
+void dropVictimRange (VC_Cache *vc, PageNumber firstPage, PageNumber lastPage);
+
+int getVictimCacheEntries (VC_Cache *vc);
+size_t getVictimCacheBytes (VC_Cache *vc);
+
+#endif